@@ -0,0 +1,195 @@
+//
+// Implementation of the CaffeEngine class
+// Classification based on the example provided by the caffe library in:
+// https://github.com/BVLC/caffe/blob/master/examples/cpp_classification/classification.cpp
+//
+
+#include "CaffeEngine.h"
+#include "Profiler.h"
+#include "TaskPool.h"
+#include <opencv2/imgproc.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <caffe/util/upgrade_proto.hpp>
+#include <dirent.h>
+#include <algorithm>
+
+using std::string;
+using namespace caffe;
+using namespace cv;
+
+CaffeEngine::CaffeEngine()
+{
+}
+
+CaffeEngine::CaffeEngine(const string &model, const string &weights, const Parameters &parameters)
+{
+    //Load network
+    this->model = model;
+    this->parameters = parameters;
+    net.reset(new Net<float>(model, TEST));
+    net->CopyTrainedLayersFrom(weights);
+    initialize();
+
+    //Quantize the network with the ranges observed over the calibration crops
+    if(parameters.backend == "int8")
+    {
+        quantized.reset(new QuantizedNet(net.get()));
+        calibrate();
+    }
+}
+
+string CaffeEngine::getName() const
+{
+    return quantized ? "int8" : "caffe";
+}
+
+Size CaffeEngine::getInputSize() const
+{
+    return geometry;
+}
+
+void CaffeEngine::submit(const Mat &crop)
+{
+    pending.push_back(crop);
+}
+
+void CaffeEngine::collect(vector<float> &probabilities)
+{
+    probabilities.clear();
+    if(pending.empty())
+        return;
+
+    //Perform prediction of the whole batch
+    {
+        ScopedTimer timer("preprocess");
+        fillInput();
+    }
+    {
+        ScopedTimer timer("forward");
+        if(quantized)
+            quantized->forward();
+        else
+            net->ForwardPrefilled();
+    }
+    Profiler::count("forward passes");
+
+    //Return the probability of being a nest of each crop
+    Blob<float>* outputLayer = net->output_blobs()[0];
+    const float* output = outputLayer->cpu_data();
+    int classes = outputLayer->count() / outputLayer->shape(0);
+    for(int r = 0; r < (int) pending.size(); ++r)
+        probabilities.push_back(output[r * classes + 1]);
+    pending.clear();
+}
+
+IInferenceEngine *CaffeEngine::share() const
+{
+    //The weights are replaced by the ones of this engine, so the fillers are made constant to avoid generating random
+    //values for them
+    NetParameter netParameter;
+    ReadNetParamsFromTextFileOrDie(model, &netParameter);
+    netParameter.mutable_state()->set_phase(TEST);
+    for(int r = 0; r < netParameter.layer_size(); ++r)
+    {
+        LayerParameter *layer = netParameter.mutable_layer(r);
+        if(layer->has_convolution_param())
+        {
+            layer->mutable_convolution_param()->mutable_weight_filler()->set_type("constant");
+            layer->mutable_convolution_param()->mutable_bias_filler()->set_type("constant");
+        }
+        if(layer->has_inner_product_param())
+        {
+            layer->mutable_inner_product_param()->mutable_weight_filler()->set_type("constant");
+            layer->mutable_inner_product_param()->mutable_bias_filler()->set_type("constant");
+        }
+    }
+
+    //Create the network with its own activations and share the trained and quantized weights of this engine
+    CaffeEngine *engine = new CaffeEngine();
+    engine->model = model;
+    engine->parameters = parameters;
+    engine->net.reset(new Net<float>(netParameter));
+    engine->net->ShareTrainedLayersWith(net.get());
+    engine->initialize();
+    if(quantized)
+        engine->quantized.reset(new QuantizedNet(engine->net.get(), *quantized));
+    return engine;
+}
+
+void CaffeEngine::initialize()
+{
+    //Get the number of channels and geometry of the model
+    Blob<float>* inputLayer = net->input_blobs()[0];
+    numberChannels = inputLayer->channels();
+    geometry = cv::Size(inputLayer->width(), inputLayer->height());
+    inputLayer->Reshape(1, numberChannels, geometry.height, geometry.width);
+    net->Reshape();
+}
+
+void CaffeEngine::calibrate()
+{
+    //Sample crops, in name order such that the quantization is the same from one run to the next one
+    vector<string> crops;
+    DIR* dir;
+    struct dirent *ent;
+    if((dir = opendir(parameters.calibrationDir.c_str())) != NULL)
+    {
+        while((ent = readdir(dir)) != NULL)
+            crops.push_back(parameters.calibrationDir + "/" + ent->d_name);
+        closedir(dir);
+    }
+    std::sort(crops.begin(), crops.end());
+
+    int samples = 0;
+    for(vector<string>::iterator it = crops.begin(); it != crops.end() && samples < parameters.calibrationSamples; ++it)
+    {
+        Mat crop = imread(*it, 1);
+        if(!crop.data)
+            continue;
+        pending.push_back(crop);
+        fillInput();
+        pending.clear();
+        quantized->observe();
+        samples++;
+    }
+    CHECK_GT(samples, 0) << "No calibration crops in " << parameters.calibrationDir;
+    quantized->quantize();
+}
+
+void CaffeEngine::fillInput()
+{
+    //Forward dimension to layers, caffe only reallocates the blobs when the batch grows
+    Blob<float>* inputLayer = net->input_blobs()[0];
+    if(inputLayer->num() != (int) pending.size())
+    {
+        inputLayer->Reshape((int) pending.size(), numberChannels, geometry.height, geometry.width);
+        net->Reshape();
+    }
+
+    //Convert openCVMat to caffe input, each crop to its own part of the blob
+    float *input = inputLayer->mutable_cpu_data();
+    TaskPool::parallelFor(0, (int) pending.size(), 4, [&](int first, int last)
+    {
+        for(int r = first; r < last; ++r)
+            processImage(pending[r], input + inputLayer->offset(r));
+    }, "preprocess crops");
+}
+
+void CaffeEngine::processImage(const Mat &image, float *input)
+{
+    //Resize the image obtained from the slide method.
+    cv::Mat resizeImage;
+    if(image.size() != geometry)
+        cv::resize(image, resizeImage, geometry);
+    else
+        resizeImage = image;
+
+    //Split the image channels and convert each of them directly into the input layer
+    vector<Mat> channels;
+    cv::split(resizeImage, channels);
+    for(int r = 0; r < (int) channels.size(); ++r)
+    {
+        Mat channel(geometry.height, geometry.width, CV_32FC1, input + r * geometry.area());
+        channels[r].convertTo(channel, CV_32F);
+    }
+}
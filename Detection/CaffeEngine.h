@@ -0,0 +1,41 @@
+//
+// Inference engine running the network with caffe, in FP32 or with the Convolution and InnerProduct layers
+// quantized to int8 by QuantizedNet.
+//
+
+#ifndef DETECTION_CAFFEENGINE_H
+#define DETECTION_CAFFEENGINE_H
+
+#include <memory>
+#include <caffe/caffe.hpp>
+#include "IInferenceEngine.h"
+#include "Parameters.h"
+#include "QuantizedNet.h"
+
+class CaffeEngine : public IInferenceEngine
+{
+public:
+    CaffeEngine(const std::string &model, const std::string &weights, const Parameters &parameters);
+    std::string getName() const;
+    cv::Size getInputSize() const;
+    void submit(const cv::Mat &crop);
+    void collect(std::vector<float> &probabilities);
+    IInferenceEngine *share() const;
+
+private:
+    std::string model;
+    Parameters parameters;
+    std::shared_ptr<caffe::Net<float>> net;
+    std::shared_ptr<QuantizedNet> quantized;
+    int numberChannels;
+    cv::Size geometry;
+    std::vector<cv::Mat> pending;
+
+    CaffeEngine();
+    void initialize();
+    void calibrate();
+    void fillInput();
+    void processImage(const cv::Mat &image, float *input);
+};
+
+#endif //DETECTION_CAFFEENGINE_H
@@ -0,0 +1,477 @@
+//
+// Created by ricardo_8990 on 8/19/15.
+// Implementation of the Classifier class
+//
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+#include "Classifier.h"
+#include "SlideWindowMethod.h"
+#include "SelectiveMethod.h"
+#include "CaffeEngine.h"
+#include "Profiler.h"
+#ifdef WITH_OPENCV_DNN
+#include "OpenCVEngine.h"
+#endif
+
+using std::string;
+using std::vector;
+using namespace cv;
+using namespace ml;
+
+Classifier::Classifier(const string &model, const string &weights, const Parameters &parameters)
+{
+    //Load network
+    engine.reset(createEngine(model, weights, parameters));
+    initialize(parameters);
+}
+
+Classifier::Classifier(const Classifier &weightsSource, const Parameters &parameters)
+{
+    //Engine with its own activations sharing the weights of the other classifier
+    engine.reset(weightsSource.engine->share());
+    initialize(parameters);
+}
+
+IInferenceEngine *Classifier::createEngine(const string &model, const string &weights, const Parameters &parameters)
+{
+#ifdef WITH_OPENCV_DNN
+    if(parameters.backend == "opencv")
+        return new OpenCVEngine(model, weights);
+#endif
+    CV_Assert(parameters.backend == "caffe" || parameters.backend == "int8");
+    return new CaffeEngine(model, weights, parameters);
+}
+
+cv::Size Classifier::getInputSize() const
+{
+    return geometry;
+}
+
+void Classifier::initialize(const Parameters &parameters)
+{
+    //Get the geometry of the model
+    geometry = engine->getInputSize();
+    this->parameters = parameters;
+    deadline = std::chrono::steady_clock::time_point::max();
+    scoredRegions = 0;
+    unscoredRegions = 0;
+    unscoredFraction = 0;
+
+    //Select either slide window or selective search method
+    if(parameters.method == ISlideMethod::SELECTIVE)
+        method.reset(new SelectiveMethod(parameters));
+    else
+        method.reset(new SlideWindowMethod(parameters.windowSize > 0 ? parameters.windowSize : geometry.height));
+
+    //The queue holds the proposals of more than one image, such that the next one can be segmented meanwhile
+    if(parameters.pipeline)
+    {
+        proposals.reset(new SpscQueue<Proposal>(2 * (unsigned long) std::max(parameters.maxRegions, 1) + 2));
+        scorer = std::thread(&Classifier::score, this);
+    }
+}
+
+Classifier::~Classifier()
+{
+    if(scorer.joinable())
+    {
+        Proposal stop;
+        stop.stop = true;
+        proposals->waitPush(stop);
+        scorer.join();
+    }
+}
+
+int Classifier::Classify(const cv::Mat &image, const cv::Mat &mask, const cv::Mat &reduced)
+{
+    Propose(image, mask, reduced);
+    return Collect();
+}
+
+/*
+ * Deadline of an image starting now, or no deadline without a frame budget
+ */
+static std::chrono::steady_clock::time_point startDeadline(float frameBudget)
+{
+    if(frameBudget <= 0)
+        return std::chrono::steady_clock::time_point::max();
+    return std::chrono::steady_clock::now() + std::chrono::microseconds((long long) (frameBudget * 1000));
+}
+
+float Classifier::Propose(const cv::Mat &image, const cv::Mat &mask, const cv::Mat &reduced)
+{
+    ScopedTimer timer("propose");
+    deadline = startDeadline(parameters.frameBudget);
+    //Only the part of the image around the pixels of the mask is searched, with a margin for the regions crossing it
+    Rect area(0, 0, image.cols, image.rows);
+    if(!mask.empty())
+    {
+        area = boundingRect(mask);
+        area.x -= parameters.maxRegionWidth;
+        area.y -= parameters.maxRegionHeight;
+        area.width += 2 * parameters.maxRegionWidth;
+        area.height += 2 * parameters.maxRegionHeight;
+        area &= Rect(0, 0, image.cols, image.rows);
+    }
+
+    //Initialize slide window
+    lastProposals.clear();
+    vector<Nest> found;
+    vector<Rect> regions;
+    vector<Rect> ranked;
+    int proposed = 0;
+    int skipped = 0;
+    if(mask.empty() || countNonZero(mask) > 0)
+    {
+        //The pixels of the mask inside each proposal are counted with the integral image of the mask
+        Mat maskSum;
+        if(!mask.empty())
+            integral(cv::min(mask, 1), maskSum, CV_32S);
+
+        //The copy of the image decoded at the proposal scale is cropped to the same area
+        if(!reduced.empty())
+        {
+            double scaleX = (double) reduced.cols / image.cols;
+            double scaleY = (double) reduced.rows / image.rows;
+            int x = (int) std::floor(area.x * scaleX);
+            int y = (int) std::floor(area.y * scaleY);
+            int right = std::min(reduced.cols, (int) std::ceil((area.x + area.width) * scaleX));
+            int bottom = std::min(reduced.rows, (int) std::ceil((area.y + area.height) * scaleY));
+            method->setReducedImage(reduced(Rect(x, y, right - x, bottom - y)));
+        }
+        method->initializeSlideWindow(image(area));
+
+        while(true)
+        {
+            //Get a proposed region
+            Rect region = method->getProposedRegion();
+
+            if(region.height == 0 && region.width == 0)
+                break;
+            region.x += area.x;
+            region.y += area.y;
+            Profiler::count("proposals");
+            proposed++;
+
+            //Skip the regions mostly outside the mask
+            if(!mask.empty())
+            {
+                int inside = maskSum.at<int>(region.y + region.height, region.x + region.width) -
+                             maskSum.at<int>(region.y, region.x + region.width) -
+                             maskSum.at<int>(region.y + region.height, region.x) + maskSum.at<int>(region.y, region.x);
+                if(inside < parameters.maskFraction * region.area())
+                {
+                    Profiler::count("proposals outside mask");
+                    skipped++;
+                    continue;
+                }
+            }
+
+            //With a deadline all the proposals are needed to rank them before they are scored
+            if(parameters.frameBudget > 0)
+                ranked.push_back(region);
+            else
+                send(found, regions, image, region);
+        }
+        method->clear();
+    }
+    if(!ranked.empty())
+    {
+        Rank(image, ranked);
+        for(vector<Rect>::iterator it = ranked.begin(); it != ranked.end(); ++it)
+            send(found, regions, image, *it);
+    }
+
+    //Mark the end of the image
+    Profiler::sampleCounters();
+    endImage(found, regions, image);
+    return proposed > 0 ? (float) skipped / proposed : 0;
+}
+
+float Classifier::Propose(const cv::Mat &image, const vector<Rect> &regions)
+{
+    //Proposals generated before, only the scores are computed
+    deadline = startDeadline(parameters.frameBudget);
+    lastProposals.clear();
+    vector<Nest> found;
+    vector<Rect> batch;
+    vector<Rect> ranked = regions;
+    if(parameters.frameBudget > 0)
+        Rank(image, ranked);
+    for(vector<Rect>::const_iterator it = ranked.begin(); it != ranked.end(); ++it)
+        send(found, batch, image, *it);
+    endImage(found, batch, image);
+    return 0;
+}
+
+const vector<Rect> &Classifier::getProposals() const
+{
+    return lastProposals;
+}
+
+void Classifier::send(vector<Nest> &found, vector<Rect> &regions, const Mat &image, Rect region)
+{
+    //Send it to the scoring thread, or classify them here in batches
+    lastProposals.push_back(region);
+    if(proposals)
+    {
+        proposals->waitPush(Proposal(image, region, deadline, false));
+        return;
+    }
+    regions.push_back(region);
+    if((int) regions.size() >= parameters.batchSize)
+        predict(found, regions, image, deadline);
+}
+
+void Classifier::endImage(vector<Nest> &found, vector<Rect> &regions, const Mat &image)
+{
+    if(proposals)
+    {
+        proposals->waitPush(Proposal(image, Rect(), deadline, true));
+        return;
+    }
+    predict(found, regions, image, deadline);
+    publish(found, scoredRegions, unscoredRegions);
+    scoredRegions = 0;
+    unscoredRegions = 0;
+}
+
+int Classifier::Collect()
+{
+    //The images are completed in the order they were proposed
+    std::unique_lock<std::mutex> lock(completedMutex);
+    while(completed.empty())
+        completedCondition.wait(lock);
+    nests.swap(completed.front());
+    completed.pop_front();
+    unscoredFraction = completedUnscored.front();
+    completedUnscored.pop_front();
+
+    //Return the number of nests
+    return (int) nests.size();
+}
+
+bool Classifier::hasCompleted()
+{
+    std::lock_guard<std::mutex> lock(completedMutex);
+    return !completed.empty();
+}
+
+float Classifier::getUnscoredFraction() const
+{
+    return unscoredFraction;
+}
+
+void Classifier::Rank(const Mat &image, vector<Rect> &regions)
+{
+    //Regions by decreasing contrast, from the integral images of the grey levels. The flat sand is scored last
+    ScopedTimer timer("rank proposals");
+    Mat gray;
+    if(image.channels() == 3)
+        cvtColor(image, gray, COLOR_BGR2GRAY);
+    else
+        gray = image;
+    Mat sum, squareSum;
+    integral(gray, sum, squareSum, CV_64F, CV_64F);
+
+    //Sorted by the negated contrast and the order of the proposal, so equal contrasts keep their order
+    vector<std::pair<double, unsigned long>> contrasts;
+    for(unsigned long r = 0; r < regions.size(); ++r)
+    {
+        const Rect &region = regions[r];
+        double values[2];
+        const Mat *sums[2] = { &sum, &squareSum };
+        for(int s = 0; s < 2; ++s)
+        {
+            const Mat &integralImage = *sums[s];
+            values[s] = integralImage.at<double>(region.y + region.height, region.x + region.width) -
+                        integralImage.at<double>(region.y, region.x + region.width) -
+                        integralImage.at<double>(region.y + region.height, region.x) +
+                        integralImage.at<double>(region.y, region.x);
+        }
+        double area = std::max(region.area(), 1);
+        double mean = values[0] / area;
+        contrasts.push_back(std::make_pair(mean * mean - values[1] / area, r));
+    }
+    std::sort(contrasts.begin(), contrasts.end());
+    vector<Rect> ranked;
+    for(unsigned long r = 0; r < contrasts.size(); ++r)
+        ranked.push_back(regions[contrasts[r].second]);
+    regions.swap(ranked);
+}
+
+float Classifier::Score(const Mat &crop)
+{
+    //Scored on the calling thread, so it can not be mixed with images being classified
+    vector<float> probabilities;
+    engine->submit(crop);
+    engine->collect(probabilities);
+    return probabilities[0];
+}
+
+void Classifier::score()
+{
+    //Proposals are batched while they keep arriving, a partial batch is scored instead of waiting for more. The end
+    //of an image does not flush the batch, the proposals of the next images already queued fill it. With nothing to
+    //score the thread sleeps until the next proposal
+    std::deque<ScoringImage> images;
+    vector<std::pair<ScoringImage *, Rect>> batch;
+    while(true)
+    {
+        Proposal proposal;
+        if(batch.empty())
+            proposals->waitPop(proposal);
+        else if(!proposals->pop(proposal))
+        {
+            scoreBatch(images, batch);
+            continue;
+        }
+
+        if(proposal.stop)
+            break;
+        if(images.empty() || images.back().closed)
+            images.push_back(ScoringImage());
+        ScoringImage &current = images.back();
+        if(proposal.last)
+        {
+            current.closed = true;
+            publishScored(images);
+            continue;
+        }
+        current.image = proposal.image;
+        current.deadline = proposal.deadline;
+        current.pending++;
+        batch.push_back(std::make_pair(&current, proposal.region));
+        if((int) batch.size() >= parameters.batchSize)
+            scoreBatch(images, batch);
+    }
+}
+
+void Classifier::scoreBatch(std::deque<ScoringImage> &images, vector<std::pair<ScoringImage *, Rect>> &batch)
+{
+    //Past the deadline of its image a region is dropped, the best ones of each image were sent first
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    vector<std::pair<ScoringImage *, Rect>> submitted;
+    for(vector<std::pair<ScoringImage *, Rect>>::iterator it = batch.begin(); it != batch.end(); ++it)
+    {
+        it->first->pending--;
+        if(now >= it->first->deadline)
+        {
+            Profiler::count("proposals past deadline");
+            it->first->unscored++;
+        }
+        else
+            submitted.push_back(*it);
+    }
+    batch.clear();
+
+    if(!submitted.empty())
+    {
+        ScopedTimer timer("score batch");
+        Profiler::count("crops scored", (long long) submitted.size());
+        for(vector<std::pair<ScoringImage *, Rect>>::iterator it = submitted.begin(); it != submitted.end(); ++it)
+            engine->submit(it->first->image(it->second));
+        vector<float> probabilities;
+        engine->collect(probabilities);
+        for(unsigned long r = 0; r < submitted.size(); ++r)
+        {
+            addPrediction(submitted[r].first->found, submitted[r].second, probabilities[r]);
+            submitted[r].first->scored++;
+        }
+    }
+    publishScored(images);
+}
+
+void Classifier::publishScored(std::deque<ScoringImage> &images)
+{
+    //The images are published in order, once all their regions are scored
+    while(!images.empty() && images.front().closed && images.front().pending == 0)
+    {
+        ScoringImage &image = images.front();
+        publish(image.found, image.scored, image.unscored);
+        images.pop_front();
+    }
+}
+
+void Classifier::publish(vector<Nest> &found, int scored, int unscored)
+{
+    Profiler::sampleCounters();
+    int total = scored + unscored;
+    float fraction = total > 0 ? (float) unscored / total : 0;
+    std::lock_guard<std::mutex> lock(completedMutex);
+    completed.push_back(vector<Nest>());
+    completed.back().swap(found);
+    completedUnscored.push_back(fraction);
+    completedCondition.notify_one();
+}
+
+vector<float> Classifier::Score(const vector<Rect> &regions, const Mat &image)
+{
+    //Submit the image of each region and collect their probabilities together
+    ScopedTimer timer("score batch");
+    Profiler::count("crops scored", (long long) regions.size());
+    for(vector<Rect>::const_iterator it = regions.begin(); it != regions.end(); ++it)
+        engine->submit(image(*it));
+    vector<float> probabilities;
+    engine->collect(probabilities);
+    return probabilities;
+}
+
+void Classifier::predict(vector<Nest> &found, vector<Rect> &regions, const Mat &inputImage,
+                         std::chrono::steady_clock::time_point imageDeadline)
+{
+    if(regions.empty())
+        return;
+
+    //Past the deadline the rest of the proposals of the image are dropped, the best ones were sent first
+    if(std::chrono::steady_clock::now() >= imageDeadline)
+    {
+        Profiler::count("proposals past deadline", (long long) regions.size());
+        unscoredRegions += (int) regions.size();
+        regions.clear();
+        return;
+    }
+    scoredRegions += (int) regions.size();
+    //Add the regions containing a nest to the vector
+    vector<float> probabilities = Score(regions, inputImage);
+    for(unsigned long r = 0; r < regions.size(); ++r)
+        addPrediction(found, regions[r], probabilities[r]);
+    regions.clear();
+}
+
+void Classifier::addPrediction(vector<Nest> &found, Rect region, float probability)
+{
+    //Check list of regions if overlaps with anyone
+    Profiler::count("nms comparisons", (long long) found.size());
+    bool isNewElement = true;
+    vector<vector<Nest>::iterator> toDelete;
+    for(vector<Nest>::iterator it = found.begin(); it != found.end(); ++it)
+    {
+        if((it->rect & region).area() <= 0)
+            continue;
+
+        //If it intersects, check the probability
+        if(probability <= it->probability)
+        {
+            isNewElement = false;
+            break;
+        }
+
+        //Delete the current element if the new probability is higher
+        toDelete.push_back(it);
+    }
+
+    for(vector<vector<Nest>::iterator>::iterator it = toDelete.begin(); it != toDelete.end(); ++it)
+    {
+        found.erase(*it.base());
+    }
+
+    if(isNewElement)
+    {
+        found.push_back(Nest(region, probability));
+    }
+}
@@ -0,0 +1,191 @@
+//
+// Created by ricardo_8990 on 7/28/15.
+//
+
+#ifndef DETECTION_CLASSIFIER_H
+#define DETECTION_CLASSIFIER_H
+
+#include <bits/stringfwd.h>
+#include <bits/stl_bvector.h>
+#include <bits/stl_pair.h>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <chrono>
+#include <opencv2/core/mat.hpp>
+#include <opencv2/ml.hpp>
+#include "ISlideMethod.h"
+#include "Parameters.h"
+#include "IInferenceEngine.h"
+#include "SpscQueue.h"
+
+/*
+ * Nest class, contain all regions obtained from the Object recognition task with a probability to be a nests.
+ * When the nests are tracked in a video each nest is a track with a persistent id which is born when it is detected,
+ * confirmed after being tracked for a few frames, coasts while its features are lost and dies when it is lost for too
+ * long or leaves the accepted sizes. The nests of still images keep the id -1 and the other fields unused.
+ */
+struct Nest
+{
+    enum TrackState { BORN, CONFIRMED, COASTING, DEAD };
+
+    int id;
+    cv::Rect rect;
+    float probability;
+    std::vector<cv::Point2f> features;
+    TrackState state;
+    int age;
+    int hits;
+    int misses;
+    int lastScored;
+
+    inline Nest(cv::Rect rect, float probability)
+    {
+        this->id = -1;
+        this->rect = rect;
+        this->probability = probability;
+        state = BORN;
+        age = 0;
+        hits = 1;
+        misses = 0;
+        lastScored = 0;
+    }
+
+    inline Nest(int id, cv::Rect rect, float probability, const std::vector<cv::Point2f> &features)
+    {
+        this->id = id;
+        this->rect = rect;
+        this->probability = probability;
+        this->features = features;
+        state = BORN;
+        age = 0;
+        hits = 1;
+        misses = 0;
+        lastScored = 0;
+    }
+};
+
+/*
+ * Region proposed in an image and sent to the scoring thread with the deadline of the image. The last element of each
+ * image has the last flag set and the classifier stops the thread with the stop flag.
+ */
+struct Proposal
+{
+    cv::Mat image;
+    cv::Rect region;
+    std::chrono::steady_clock::time_point deadline;
+    bool last;
+    bool stop;
+
+    inline Proposal()
+    {
+        deadline = std::chrono::steady_clock::time_point::max();
+        last = false;
+        stop = false;
+    }
+
+    inline Proposal(const cv::Mat &image, cv::Rect region, std::chrono::steady_clock::time_point deadline, bool last)
+    {
+        this->image = image;
+        this->region = region;
+        this->deadline = deadline;
+        this->last = last;
+        stop = false;
+    }
+};
+
+/*
+ * Image whose proposals are being scored by the scoring thread. It is closed when its last proposal arrives and
+ * published once none of its regions is left in the batch.
+ */
+struct ScoringImage
+{
+    cv::Mat image;
+    std::chrono::steady_clock::time_point deadline;
+    std::vector<Nest> found;
+    int scored;
+    int unscored;
+    int pending;
+    bool closed;
+
+    inline ScoringImage()
+    {
+        deadline = std::chrono::steady_clock::time_point::max();
+        scored = 0;
+        unscored = 0;
+        pending = 0;
+        closed = false;
+    }
+};
+
+/*
+ * Classifier class, it creates the structure for the ConvNet architecture and detect nests from an image using the
+ * Classify function which receives each frame. With the pipeline enabled the proposals are scored by another thread,
+ * Propose can then be called for the next image before the nests of the previous one are taken with Collect, it
+ * returns the fraction of the proposals skipped because they were mostly outside the mask. The regions sent to the
+ * network are kept until the next image, and can be given back to Propose to score them again with another model
+ * without generating them. Score runs the network over given regions on the calling thread, which is what the
+ * Tracker uses for the video frames. With a frame budget the proposals are ranked and the ones still waiting when the
+ * deadline of the image passes are not scored, getUnscoredFraction tells how many of the last image collected. The
+ * scoring thread fills its batches with the proposals of the next images when they are already queued, and
+ * hasCompleted tells whether Collect would return without waiting.
+ */
+class Classifier
+{
+public:
+    Classifier(const std::string& model, const std::string& weights, const Parameters &parameters);
+    Classifier(const Classifier &weightsSource, const Parameters &parameters);
+    ~Classifier();
+    int Classify(const cv::Mat& image, const cv::Mat &mask = cv::Mat(), const cv::Mat &reduced = cv::Mat());
+    float Propose(const cv::Mat& image, const cv::Mat &mask = cv::Mat(), const cv::Mat &reduced = cv::Mat());
+    float Propose(const cv::Mat& image, const std::vector<cv::Rect> &regions);
+    const std::vector<cv::Rect> &getProposals() const;
+    int Collect();
+    bool hasCompleted();
+    float getUnscoredFraction() const;
+    float Score(const cv::Mat &crop);
+    std::vector<float> Score(const std::vector<cv::Rect> &regions, const cv::Mat &image);
+    cv::Size getInputSize() const;
+    static void Rank(const cv::Mat &image, std::vector<cv::Rect> &regions);
+    static IInferenceEngine *createEngine(const std::string& model, const std::string& weights,
+                                          const Parameters &parameters);
+
+    std::vector<Nest> nests;
+private:
+    void initialize(const Parameters &parameters);
+    void predict(std::vector<Nest> &found, std::vector<cv::Rect> &regions, const cv::Mat &inputImage,
+                 std::chrono::steady_clock::time_point imageDeadline);
+    void addPrediction(std::vector<Nest> &found, cv::Rect region, float probability);
+    void score();
+    void scoreBatch(std::deque<ScoringImage> &images, std::vector<std::pair<ScoringImage *, cv::Rect>> &batch);
+    void publishScored(std::deque<ScoringImage> &images);
+    void publish(std::vector<Nest> &found, int scored, int unscored);
+    void send(std::vector<Nest> &found, std::vector<cv::Rect> &regions, const cv::Mat &image, cv::Rect region);
+    void endImage(std::vector<Nest> &found, std::vector<cv::Rect> &regions, const cv::Mat &image);
+
+private:
+    std::shared_ptr<IInferenceEngine> engine;
+    cv::Size geometry;
+    std::unique_ptr<ISlideMethod> method;
+    Parameters parameters;
+    std::vector<cv::Rect> lastProposals;
+    std::chrono::steady_clock::time_point deadline;
+
+    //Regions of the image being scored which were scored or left unscored by the deadline
+    int scoredRegions;
+    int unscoredRegions;
+    float unscoredFraction;
+
+    //Proposals waiting to be scored and nests of the images scored but not collected yet
+    std::shared_ptr<SpscQueue<Proposal>> proposals;
+    std::thread scorer;
+    std::mutex completedMutex;
+    std::condition_variable completedCondition;
+    std::deque<std::vector<Nest>> completed;
+    std::deque<float> completedUnscored;
+};
+
+
+#endif //DETECTION_CLASSIFIER_H
@@ -0,0 +1,26 @@
+//
+// Interface of the engines running the network over crops of the image. The crops are submitted one by one and the
+// probabilities of being a nest of all of them are collected together, such that each engine can run them as a
+// batch.
+//
+
+#ifndef DETECTION_IINFERENCEENGINE_H
+#define DETECTION_IINFERENCEENGINE_H
+
+#include <string>
+#include <vector>
+#include <opencv2/core/mat.hpp>
+
+class IInferenceEngine
+{
+public:
+    virtual ~IInferenceEngine() {}
+    virtual std::string getName() const = 0;
+    virtual cv::Size getInputSize() const = 0;
+    virtual void submit(const cv::Mat &crop) = 0;
+    virtual void collect(std::vector<float> &probabilities) = 0;
+    //New engine for another thread, sharing the weights whenever the engine allows it
+    virtual IInferenceEngine *share() const = 0;
+};
+
+#endif //DETECTION_IINFERENCEENGINE_H
@@ -0,0 +1,23 @@
+//
+// Created by ricardo_8990 on 8/19/15.
+//
+
+#ifndef DETECTION_ISLIDEMETHOD_H
+#define DETECTION_ISLIDEMETHOD_H
+
+#include <opencv2/core/mat.hpp>
+
+class ISlideMethod
+{
+public:
+    virtual ~ISlideMethod() {}
+    virtual void initializeSlideWindow(cv::Mat image) = 0;
+    virtual cv::Rect getProposedRegion() = 0;
+    enum SlideMethodType { WINDOW, SELECTIVE };
+    virtual void clear() = 0;
+
+    //Copy of the next image already reduced for the proposals, only used by the methods working at a lower scale
+    virtual void setReducedImage(cv::Mat reduced) {}
+};
+
+#endif //DETECTION_ISLIDEMETHOD_H
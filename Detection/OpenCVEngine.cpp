@@ -0,0 +1,87 @@
+//
+// Implementation of the OpenCVEngine class
+//
+
+#include "OpenCVEngine.h"
+#include "Profiler.h"
+#include <caffe/caffe.hpp>
+#include <caffe/util/upgrade_proto.hpp>
+
+using namespace std;
+using namespace cv;
+
+/*
+ * Size of the input of the network, given either by the input fields or by an Input layer of the prototxt
+ */
+static Size readInputSize(const string &model)
+{
+    caffe::NetParameter netParameter;
+    caffe::ReadNetParamsFromTextFileOrDie(model, &netParameter);
+    if(netParameter.input_shape_size() > 0 && netParameter.input_shape(0).dim_size() == 4)
+        return Size((int) netParameter.input_shape(0).dim(3), (int) netParameter.input_shape(0).dim(2));
+    if(netParameter.input_dim_size() == 4)
+        return Size(netParameter.input_dim(3), netParameter.input_dim(2));
+    for(int r = 0; r < netParameter.layer_size(); ++r)
+    {
+        const caffe::LayerParameter &layer = netParameter.layer(r);
+        if(layer.type() == "Input" && layer.input_param().shape_size() > 0 &&
+           layer.input_param().shape(0).dim_size() == 4)
+            return Size((int) layer.input_param().shape(0).dim(3), (int) layer.input_param().shape(0).dim(2));
+    }
+    return Size();
+}
+
+OpenCVEngine::OpenCVEngine(const string &model, const string &weights)
+{
+    this->model = model;
+    this->weights = weights;
+    net = dnn::readNetFromCaffe(model, weights);
+    CV_Assert(!net.empty());
+    geometry = readInputSize(model);
+    CV_Assert(geometry.area() > 0);
+}
+
+string OpenCVEngine::getName() const
+{
+    return "opencv";
+}
+
+Size OpenCVEngine::getInputSize() const
+{
+    return geometry;
+}
+
+void OpenCVEngine::submit(const Mat &crop)
+{
+    pending.push_back(crop);
+}
+
+void OpenCVEngine::collect(vector<float> &probabilities)
+{
+    probabilities.clear();
+    if(pending.empty())
+        return;
+
+    //Same input as the caffe engine: resized BGR crops in float without mean or scaling
+    Mat output;
+    {
+        ScopedTimer timer("preprocess");
+        Mat input = dnn::blobFromImages(pending, 1.0, geometry, Scalar(), false, false);
+        net.setInput(input);
+    }
+    {
+        ScopedTimer timer("forward");
+        output = net.forward();
+    }
+    Profiler::count("forward passes");
+    output = output.reshape(1, (int) pending.size());
+    for(int r = 0; r < output.rows; ++r)
+        probabilities.push_back(output.at<float>(r, 1));
+    pending.clear();
+}
+
+IInferenceEngine *OpenCVEngine::share() const
+{
+    //A dnn::Net can not be used by several threads and its copies share the same state, so the model is loaded again
+    return new OpenCVEngine(model, weights);
+}
@@ -0,0 +1,30 @@
+//
+// Inference engine running the caffe model with the dnn module of OpenCV (3.3 or later), built with
+// WITH_OPENCV_DNN.
+//
+
+#ifndef DETECTION_OPENCVENGINE_H
+#define DETECTION_OPENCVENGINE_H
+
+#include <opencv2/dnn.hpp>
+#include "IInferenceEngine.h"
+
+class OpenCVEngine : public IInferenceEngine
+{
+public:
+    OpenCVEngine(const std::string &model, const std::string &weights);
+    std::string getName() const;
+    cv::Size getInputSize() const;
+    void submit(const cv::Mat &crop);
+    void collect(std::vector<float> &probabilities);
+    IInferenceEngine *share() const;
+
+private:
+    std::string model;
+    std::string weights;
+    cv::dnn::Net net;
+    cv::Size geometry;
+    std::vector<cv::Mat> pending;
+};
+
+#endif //DETECTION_OPENCVENGINE_H
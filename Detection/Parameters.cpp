@@ -0,0 +1,474 @@
+//
+// Implementation of the Parameters structure
+//
+
+#include "Parameters.h"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <cstdlib>
+#include <algorithm>
+
+using namespace std;
+
+template <typename T>
+static bool parseValue(const string &value, T &output)
+{
+    istringstream stream(value);
+    T parsed;
+    if(!(stream >> parsed) || !(stream >> ws).eof())
+        return false;
+    output = parsed;
+    return true;
+}
+
+template <>
+bool parseValue<string>(const string &value, string &output)
+{
+    output = value;
+    return true;
+}
+
+/*
+ * Configuration written by the calibration of the host, in the home of the user
+ */
+static string defaultTunedFile()
+{
+    const char *home = getenv("HOME");
+    return home != NULL ? string(home) + "/.alagba/tuned.cfg" : "";
+}
+
+static string trim(const string &text)
+{
+    string::size_type begin = text.find_first_not_of(" \t\r");
+    if(begin == string::npos)
+        return "";
+    string::size_type end = text.find_last_not_of(" \t\r");
+    return text.substr(begin, end - begin + 1);
+}
+
+Parameters::Parameters()
+{
+    method = ISlideMethod::SELECTIVE;
+    windowSize = 0;
+    sigma = 0.8;
+    k = 200;
+    minSize = 200;
+    maxRegions = 2000;
+    proposalScale = 1;
+    decodeReduced = 0;
+    minRegionWidth = 50;
+    minRegionHeight = 50;
+    maxRegionWidth = 347;
+    maxRegionHeight = 429;
+    threshold = 0.5;
+    frameBudget = 0;
+    lkWindow = 31;
+    pyramidLevels = 3;
+    featuresPerNest = 8;
+    featureQuality = 0.05;
+    fbThreshold = 1.0;
+    probabilityAlpha = 0.3;
+    confirmFrames = 3;
+    maxCoastFrames = 10;
+    rescoreInterval = 5;
+    display = 1;
+    writeVideo = 1;
+    writeDetections = 0;
+    workers = 0;
+    resultsFormat = "jsonl";
+    annotate = 1;
+    poseFile = "";
+    focalLength = 0;
+    principalX = -1;
+    principalY = -1;
+    dedupRadius = 2.0;
+    targetGsd = 0;
+    minNestSize = 0;
+    maxNestSize = 0;
+    survey = 0;
+    surveyMemory = 5;
+    surveyFeatures = 2000;
+    surveyScale = 0.25;
+    maskFraction = 0.5;
+    sandMask = 0;
+    sandHueMin = 0;
+    sandHueMax = 35;
+    sandSaturationMax = 150;
+    sandValueMin = 80;
+    sandMaskScale = 0.25;
+    tileSize = 0;
+    tileOverlap = 450;
+    cacheDir = "";
+    queueDir = "";
+    queueBatch = 8;
+    claimTimeout = 3600;
+    workerName = "";
+    serve = "";
+    backend = "caffe";
+    calibrationDir = "";
+    calibrationSamples = 200;
+    evaluatePositive = "";
+    evaluateNegative = "";
+    batchSize = 16;
+    benchmark = "";
+    tune = "";
+    tuned = defaultTunedFile();
+    pipeline = 1;
+    poolThreads = 0;
+    profile = "";
+    regression = "";
+    corpus = "";
+    labelTolerance = 0;
+    proposalTolerance = 0;
+    probabilityTolerance = 0.001;
+    detectionTolerance = 0;
+}
+
+bool Parameters::set(const string &name, const string &value)
+{
+    if(name == "method")
+    {
+        if(value == "selective")
+            method = ISlideMethod::SELECTIVE;
+        else if(value == "window")
+            method = ISlideMethod::WINDOW;
+        else
+            return false;
+        return true;
+    }
+    if(name == "windowSize")
+        return parseValue(value, windowSize);
+    if(name == "sigma")
+        return parseValue(value, sigma);
+    if(name == "k")
+        return parseValue(value, k);
+    if(name == "minSize")
+        return parseValue(value, minSize);
+    if(name == "maxRegions")
+        return parseValue(value, maxRegions);
+    if(name == "proposalScale")
+        return parseValue(value, proposalScale) && proposalScale > 0 && proposalScale <= 1;
+    if(name == "decodeReduced")
+        return parseValue(value, decodeReduced);
+    if(name == "minRegionWidth")
+        return parseValue(value, minRegionWidth) && minRegionWidth >= 0;
+    if(name == "minRegionHeight")
+        return parseValue(value, minRegionHeight) && minRegionHeight >= 0;
+    if(name == "maxRegionWidth")
+        return parseValue(value, maxRegionWidth) && maxRegionWidth > 0;
+    if(name == "maxRegionHeight")
+        return parseValue(value, maxRegionHeight) && maxRegionHeight > 0;
+    if(name == "threshold")
+        return parseValue(value, threshold);
+    if(name == "frameBudget")
+        return parseValue(value, frameBudget) && frameBudget >= 0;
+    if(name == "lkWindow")
+        return parseValue(value, lkWindow) && lkWindow >= 3 && lkWindow % 2 == 1;
+    if(name == "pyramidLevels")
+        return parseValue(value, pyramidLevels) && pyramidLevels >= 0;
+    if(name == "featuresPerNest")
+        return parseValue(value, featuresPerNest) && featuresPerNest > 0;
+    if(name == "featureQuality")
+        return parseValue(value, featureQuality);
+    if(name == "fbThreshold")
+        return parseValue(value, fbThreshold);
+    if(name == "probabilityAlpha")
+        return parseValue(value, probabilityAlpha) && probabilityAlpha >= 0 && probabilityAlpha <= 1;
+    if(name == "confirmFrames")
+        return parseValue(value, confirmFrames) && confirmFrames >= 1;
+    if(name == "maxCoastFrames")
+        return parseValue(value, maxCoastFrames) && maxCoastFrames >= 0;
+    if(name == "rescoreInterval")
+        return parseValue(value, rescoreInterval) && rescoreInterval >= 1;
+    if(name == "display")
+        return parseValue(value, display);
+    if(name == "writeVideo")
+        return parseValue(value, writeVideo);
+    if(name == "writeDetections")
+        return parseValue(value, writeDetections);
+    if(name == "workers")
+        return parseValue(value, workers) && workers >= 0;
+    if(name == "resultsFormat")
+        return parseValue(value, resultsFormat);
+    if(name == "annotate")
+        return parseValue(value, annotate);
+    if(name == "poseFile")
+        return parseValue(value, poseFile);
+    if(name == "focalLength")
+        return parseValue(value, focalLength);
+    if(name == "principalX")
+        return parseValue(value, principalX);
+    if(name == "principalY")
+        return parseValue(value, principalY);
+    if(name == "dedupRadius")
+        return parseValue(value, dedupRadius) && dedupRadius > 0;
+    if(name == "targetGsd")
+        return parseValue(value, targetGsd) && targetGsd >= 0;
+    if(name == "minNestSize")
+        return parseValue(value, minNestSize) && minNestSize >= 0;
+    if(name == "maxNestSize")
+        return parseValue(value, maxNestSize) && maxNestSize >= 0;
+    if(name == "survey")
+        return parseValue(value, survey);
+    if(name == "surveyMemory")
+        return parseValue(value, surveyMemory) && surveyMemory > 0;
+    if(name == "surveyFeatures")
+        return parseValue(value, surveyFeatures) && surveyFeatures > 0;
+    if(name == "surveyScale")
+        return parseValue(value, surveyScale) && surveyScale > 0 && surveyScale <= 1;
+    if(name == "maskFraction")
+        return parseValue(value, maskFraction);
+    if(name == "sandMask")
+        return parseValue(value, sandMask);
+    if(name == "sandHueMin")
+        return parseValue(value, sandHueMin);
+    if(name == "sandHueMax")
+        return parseValue(value, sandHueMax);
+    if(name == "sandSaturationMax")
+        return parseValue(value, sandSaturationMax);
+    if(name == "sandValueMin")
+        return parseValue(value, sandValueMin);
+    if(name == "sandMaskScale")
+        return parseValue(value, sandMaskScale) && sandMaskScale > 0 && sandMaskScale <= 1;
+    if(name == "tileSize")
+        return parseValue(value, tileSize) && tileSize >= 0;
+    if(name == "tileOverlap")
+        return parseValue(value, tileOverlap) && tileOverlap >= 0;
+    if(name == "cacheDir")
+        return parseValue(value, cacheDir);
+    if(name == "queueDir")
+        return parseValue(value, queueDir);
+    if(name == "queueBatch")
+        return parseValue(value, queueBatch) && queueBatch > 0;
+    if(name == "claimTimeout")
+        return parseValue(value, claimTimeout) && claimTimeout > 0;
+    if(name == "workerName")
+        return parseValue(value, workerName);
+    if(name == "serve")
+        return parseValue(value, serve);
+    if(name == "backend")
+    {
+        if(value != "caffe" && value != "int8" && value != "opencv")
+            return false;
+        backend = value;
+        return true;
+    }
+    if(name == "calibrationDir")
+        return parseValue(value, calibrationDir);
+    if(name == "calibrationSamples")
+        return parseValue(value, calibrationSamples) && calibrationSamples > 0;
+    if(name == "evaluatePositive")
+        return parseValue(value, evaluatePositive);
+    if(name == "evaluateNegative")
+        return parseValue(value, evaluateNegative);
+    if(name == "batchSize")
+        return parseValue(value, batchSize) && batchSize > 0;
+    if(name == "benchmark")
+        return parseValue(value, benchmark);
+    if(name == "tune")
+        return parseValue(value, tune);
+    if(name == "tuned")
+        return parseValue(value, tuned);
+    if(name == "pipeline")
+        return parseValue(value, pipeline);
+    if(name == "poolThreads")
+        return parseValue(value, poolThreads) && poolThreads >= 0;
+    if(name == "profile")
+        return parseValue(value, profile);
+    if(name == "regression")
+    {
+        if(!value.empty() && value != "record" && value != "verify")
+            return false;
+        regression = value;
+        return true;
+    }
+    if(name == "corpus")
+        return parseValue(value, corpus);
+    if(name == "labelTolerance")
+        return parseValue(value, labelTolerance);
+    if(name == "proposalTolerance")
+        return parseValue(value, proposalTolerance);
+    if(name == "probabilityTolerance")
+        return parseValue(value, probabilityTolerance);
+    if(name == "detectionTolerance")
+        return parseValue(value, detectionTolerance);
+    return false;
+}
+
+bool Parameters::load(const string &fileName, const vector<string> &names)
+{
+    ifstream file(fileName.c_str());
+    if(!file.is_open())
+    {
+        cerr << "Could not open configuration file " << fileName << endl;
+        return false;
+    }
+
+    string line;
+    int lineNumber = 0;
+    while(getline(file, line))
+    {
+        lineNumber++;
+        //Remove comments and empty lines
+        string::size_type comment = line.find('#');
+        if(comment != string::npos)
+            line.erase(comment);
+        line = trim(line);
+        if(line.empty())
+            continue;
+
+        string::size_type equal = line.find('=');
+        if(equal != string::npos && !names.empty() &&
+           std::find(names.begin(), names.end(), trim(line.substr(0, equal))) == names.end())
+            continue;
+        if(equal == string::npos || !set(trim(line.substr(0, equal)), trim(line.substr(equal + 1))))
+        {
+            cerr << fileName << ":" << lineNumber << ": invalid parameter \"" << line << "\"" << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Parameters::parseArguments(int argc, char **argv, vector<string> &positional, bool tunedWorkers)
+{
+    //The tuned configuration of the host is loaded before everything else, unless another one is given with --tuned.
+    //The workers were measured as images in flight, so they are only taken by the programs where they mean that
+    for(int r = 1; r < argc; ++r)
+    {
+        string argument = argv[r];
+        if(argument.compare(0, 8, "--tuned=") == 0)
+            tuned = argument.substr(8);
+    }
+    vector<string> tunedNames;
+    tunedNames.push_back("batchSize");
+    tunedNames.push_back("pipeline");
+    tunedNames.push_back("poolThreads");
+    if(tunedWorkers)
+        tunedNames.push_back("workers");
+    ifstream tunedFile(tuned.c_str());
+    if(!tuned.empty() && tunedFile.is_open() && !load(tuned, tunedNames))
+        return false;
+
+    //The configuration file is loaded first such that the rest of options override it
+    vector<string> options;
+    for(int r = 1; r < argc; ++r)
+    {
+        string argument = argv[r];
+        if(argument.compare(0, 2, "--") != 0)
+        {
+            positional.push_back(argument);
+            continue;
+        }
+
+        if(argument.compare(0, 9, "--config=") == 0)
+        {
+            if(!load(argument.substr(9)))
+                return false;
+        }
+        else
+            options.push_back(argument.substr(2));
+    }
+
+    for(vector<string>::iterator it = options.begin(); it != options.end(); ++it)
+    {
+        string::size_type equal = it->find('=');
+        if(equal == string::npos || !set(it->substr(0, equal), it->substr(equal + 1)))
+        {
+            cerr << "Invalid option --" << *it << endl;
+            return false;
+        }
+    }
+
+    //The bounds set by different lines or options are checked once all of them are set
+    if(minRegionWidth > maxRegionWidth || minRegionHeight > maxRegionHeight)
+    {
+        cerr << "The minimum region size is larger than the maximum" << endl;
+        return false;
+    }
+    if(minNestSize > 0 && maxNestSize > 0 && minNestSize > maxNestSize)
+    {
+        cerr << "The minimum nest size is larger than the maximum" << endl;
+        return false;
+    }
+    return true;
+}
+
+void Parameters::print(ostream &output) const
+{
+    output << "method = " << (method == ISlideMethod::SELECTIVE ? "selective" : "window") << "\n";
+    output << "windowSize = " << windowSize << "\n";
+    output << "sigma = " << sigma << "\n";
+    output << "k = " << k << "\n";
+    output << "minSize = " << minSize << "\n";
+    output << "maxRegions = " << maxRegions << "\n";
+    output << "proposalScale = " << proposalScale << "\n";
+    output << "decodeReduced = " << decodeReduced << "\n";
+    output << "minRegionWidth = " << minRegionWidth << "\n";
+    output << "minRegionHeight = " << minRegionHeight << "\n";
+    output << "maxRegionWidth = " << maxRegionWidth << "\n";
+    output << "maxRegionHeight = " << maxRegionHeight << "\n";
+    output << "threshold = " << threshold << "\n";
+    output << "frameBudget = " << frameBudget << "\n";
+    output << "lkWindow = " << lkWindow << "\n";
+    output << "pyramidLevels = " << pyramidLevels << "\n";
+    output << "featuresPerNest = " << featuresPerNest << "\n";
+    output << "featureQuality = " << featureQuality << "\n";
+    output << "fbThreshold = " << fbThreshold << "\n";
+    output << "probabilityAlpha = " << probabilityAlpha << "\n";
+    output << "confirmFrames = " << confirmFrames << "\n";
+    output << "maxCoastFrames = " << maxCoastFrames << "\n";
+    output << "rescoreInterval = " << rescoreInterval << "\n";
+    output << "display = " << display << "\n";
+    output << "writeVideo = " << writeVideo << "\n";
+    output << "writeDetections = " << writeDetections << "\n";
+    output << "workers = " << workers << "\n";
+    output << "resultsFormat = " << resultsFormat << "\n";
+    output << "annotate = " << annotate << "\n";
+    output << "poseFile = " << poseFile << "\n";
+    output << "focalLength = " << focalLength << "\n";
+    output << "principalX = " << principalX << "\n";
+    output << "principalY = " << principalY << "\n";
+    output << "dedupRadius = " << dedupRadius << "\n";
+    output << "targetGsd = " << targetGsd << "\n";
+    output << "minNestSize = " << minNestSize << "\n";
+    output << "maxNestSize = " << maxNestSize << "\n";
+    output << "survey = " << survey << "\n";
+    output << "surveyMemory = " << surveyMemory << "\n";
+    output << "surveyFeatures = " << surveyFeatures << "\n";
+    output << "surveyScale = " << surveyScale << "\n";
+    output << "maskFraction = " << maskFraction << "\n";
+    output << "sandMask = " << sandMask << "\n";
+    output << "sandHueMin = " << sandHueMin << "\n";
+    output << "sandHueMax = " << sandHueMax << "\n";
+    output << "sandSaturationMax = " << sandSaturationMax << "\n";
+    output << "sandValueMin = " << sandValueMin << "\n";
+    output << "sandMaskScale = " << sandMaskScale << "\n";
+    output << "tileSize = " << tileSize << "\n";
+    output << "tileOverlap = " << tileOverlap << "\n";
+    output << "cacheDir = " << cacheDir << "\n";
+    output << "queueDir = " << queueDir << "\n";
+    output << "queueBatch = " << queueBatch << "\n";
+    output << "claimTimeout = " << claimTimeout << "\n";
+    output << "workerName = " << workerName << "\n";
+    output << "serve = " << serve << "\n";
+    output << "backend = " << backend << "\n";
+    output << "calibrationDir = " << calibrationDir << "\n";
+    output << "calibrationSamples = " << calibrationSamples << "\n";
+    output << "evaluatePositive = " << evaluatePositive << "\n";
+    output << "evaluateNegative = " << evaluateNegative << "\n";
+    output << "batchSize = " << batchSize << "\n";
+    output << "benchmark = " << benchmark << "\n";
+    output << "tune = " << tune << "\n";
+    output << "tuned = " << tuned << "\n";
+    output << "pipeline = " << pipeline << "\n";
+    output << "poolThreads = " << poolThreads << "\n";
+    output << "profile = " << profile << "\n";
+    output << "regression = " << regression << "\n";
+    output << "corpus = " << corpus << "\n";
+    output << "labelTolerance = " << labelTolerance << "\n";
+    output << "proposalTolerance = " << proposalTolerance << "\n";
+    output << "probabilityTolerance = " << probabilityTolerance << "\n";
+    output << "detectionTolerance = " << detectionTolerance << "\n";
+}
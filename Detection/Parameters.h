@@ -0,0 +1,176 @@
+//
+// Parameters used along the detection process. The default values are the ones used in the dissertation, they can
+// be changed from a configuration file with lines "name = value" and overridden from the command line with
+// --name=value.
+//
+
+#ifndef DETECTION_PARAMETERS_H
+#define DETECTION_PARAMETERS_H
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include "ISlideMethod.h"
+
+struct Parameters
+{
+    //Region proposal method
+    ISlideMethod::SlideMethodType method;
+    int windowSize;
+
+    //Selective search segmentation and grouping
+    float sigma;
+    int k;
+    int minSize;
+    int maxRegions;
+
+    //Proposals are generated on a copy of the image resized by this factor (at most 1) and mapped back to the full
+    //resolution, the crops classified are still taken from the original image. With decodeReduced the copy of the
+    //images of NestRecognition is decoded at that size when the factor is 1/2, 1/4 or 1/8
+    float proposalScale;
+    bool decodeReduced;
+
+    //Size bounds of the regions accepted by the ConvNet
+    int minRegionWidth;
+    int minRegionHeight;
+    int maxRegionWidth;
+    int maxRegionHeight;
+
+    //Probability from which a region is considered a nest
+    float threshold;
+
+    //Deadline in milliseconds of each image or frame, 0 scores every proposal. With a deadline the proposals are
+    //scored by decreasing contrast until it runs out, and the tracker scores the remaining ones in the next frame
+    float frameBudget;
+
+    //Lucas-Kanade optical flow, features tracked per nest and forward-backward error allowed
+    int lkWindow;
+    int pyramidLevels;
+    int featuresPerNest;
+    float featureQuality;
+    float fbThreshold;
+
+    //Track lifecycle: smoothing of the probability, frames to confirm a track, frames a lost track is kept and
+    //frames between the ConvNet scores of a confirmed track
+    float probabilityAlpha;
+    int confirmFrames;
+    int maxCoastFrames;
+    int rescoreInterval;
+
+    //Output: window with the processed frames, annotated video, detections file and number of videos processed at once,
+    //format of the structured results (jsonl, csv or none) and annotated images
+    bool display;
+    bool writeVideo;
+    bool writeDetections;
+    int workers;
+    std::string resultsFormat;
+    bool annotate;
+
+    //Georeference: CSV file with the pose of each image (image,latitude,longitude,altitude,yaw,pitch,roll), focal
+    //length and principal point of the camera in pixels (-1 is the centre of the image) and distance in metres under
+    //which two detections are the same nest
+    std::string poseFile;
+    float focalLength;
+    float principalX;
+    float principalY;
+    float dedupRadius;
+
+    //Ground resolution normalisation: with the poses each image is rescaled to targetGsd metres per pixel before the
+    //detection (0 keeps the resolution of the camera), and the nest size bounds in metres (0 keeps the pixel bounds)
+    //replace the region size bounds at that resolution
+    float targetGsd;
+    float minNestSize;
+    float maxNestSize;
+
+    //Survey mode: consecutive images are registered and only the ground not covered by the last surveyMemory
+    //images is searched, registration is done with surveyFeatures ORB features over the image scaled by surveyScale and
+    //proposals with less than maskFraction of their area inside the area to search are skipped
+    bool survey;
+    int surveyMemory;
+    int surveyFeatures;
+    float surveyScale;
+    float maskFraction;
+
+    //Beach mask: pixels with a hue between sandHueMin and sandHueMax (0-180), a saturation up to sandSaturationMax and
+    //a value from sandValueMin are sand, computed over the image scaled by sandMaskScale. Proposals with less than
+    //maskFraction of their area on sand are skipped before the ConvNet
+    bool sandMask;
+    int sandHueMin;
+    int sandHueMax;
+    int sandSaturationMax;
+    int sandValueMin;
+    float sandMaskScale;
+
+    //Orthomosaics larger than the memory: with a tileSize the binary PPM images of the folder are read through a memory
+    //mapping in tiles of tileSize pixels overlapping by tileOverlap pixels (at least the largest region), and the nests
+    //of the tiles are stitched together
+    int tileSize;
+    int tileOverlap;
+
+    //Results cache: the nests of each image are stored in cacheDir under the hash of the content of the image, the
+    //parameters and the model, and the proposals under the hash of the image and the proposal parameters. An
+    //interrupted run restarts from the images not stored yet, and a new model reuses the proposals
+    std::string cacheDir;
+
+    //Sharding: processes sharing queueDir (also on several machines over a shared filesystem) claim batches of
+    //queueBatch images by renaming them, a claim not renewed for claimTimeout seconds is taken by another worker.
+    //Each worker writes its own results, merged by the last one to finish. workerName defaults to host-pid
+    std::string queueDir;
+    int queueBatch;
+    int claimTimeout;
+    std::string workerName;
+
+    //Resident server: the model stays loaded and classifies the images sent over the Unix socket serve, the
+    //requests of all the clients are served by the same workers and the nests of each one are streamed back
+    std::string serve;
+
+    //Inference backend: "caffe" (FP32), "opencv" (dnn module) or "int8", quantized after training with the ranges
+    //observed over up to calibrationSamples crops of calibrationDir. evaluatePositive/evaluateNegative are folders of
+    //held-out crops used to report the accuracy of the backend against FP32
+    std::string backend;
+    std::string calibrationDir;
+    int calibrationSamples;
+    std::string evaluatePositive;
+    std::string evaluateNegative;
+
+    //Number of crops scored together by the inference engine and folder of crops used to compare the speed of the
+    //engines
+    int batchSize;
+    std::string benchmark;
+
+    //Calibration of the host: the images of the folder tune are classified with a grid of batch sizes and
+    //workers, with and without pipeline and pool threads, and the fastest configuration is written to tuned. The
+    //tuned file is loaded before the configuration file and the options, it defaults to ~/.alagba/tuned.cfg and
+    //empty disables it
+    std::string tune;
+    std::string tuned;
+
+    //Generate the proposals of the next image while the proposals of the current one are scored by another thread
+    bool pipeline;
+
+    //Threads of the pool running the parallel loops of the segmentation, the region histograms and the
+    //preprocessing of the crops, counting the threads which call them. 0 uses every core
+    int poolThreads;
+
+    //Chrome trace (chrome://tracing, Perfetto) written with the time of each stage and the counters, the summary
+    //statistics are written with the rest of the results. Nothing is recorded when empty
+    std::string profile;
+
+    //Golden corpus: "record" stores the label maps, proposals and detections of the images in corpus/images,
+    //"verify" checks them again within the tolerances (fraction of pixels with a different segmentation, fraction of
+    //proposals changed, probability difference and loss of precision/recall of the detections) and times each stage
+    std::string regression;
+    std::string corpus;
+    float labelTolerance;
+    float proposalTolerance;
+    float probabilityTolerance;
+    float detectionTolerance;
+
+    Parameters();
+    bool load(const std::string &fileName, const std::vector<std::string> &names = std::vector<std::string>());
+    bool set(const std::string &name, const std::string &value);
+    bool parseArguments(int argc, char **argv, std::vector<std::string> &positional, bool tunedWorkers = true);
+    void print(std::ostream &output) const;
+};
+
+#endif //DETECTION_PARAMETERS_H
@@ -0,0 +1,174 @@
+//
+// Implementation of the Profiler class
+//
+
+#include "Profiler.h"
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <fstream>
+#include <algorithm>
+
+using namespace std;
+using namespace std::chrono;
+
+/*
+ * Timer (phase 'X') or counter sample (phase 'C') of the trace
+ */
+struct TraceEvent
+{
+    const char *name;
+    char phase;
+    long long start;
+    long long value;
+};
+
+/*
+ * Events and counters of a thread, only written by that thread
+ */
+struct ThreadBuffer
+{
+    int thread;
+    vector<TraceEvent> events;
+    vector<pair<const char*, long long>> counters;
+};
+
+atomic<bool> Profiler::enabled(false);
+
+static mutex buffersMutex;
+static vector<unique_ptr<ThreadBuffer>> buffers;
+static const steady_clock::time_point origin = steady_clock::now();
+
+static ThreadBuffer &threadBuffer()
+{
+    //Registered the first time a thread records something, the buffers live until the end of the program
+    static thread_local ThreadBuffer *buffer = NULL;
+    if(buffer == NULL)
+    {
+        lock_guard<mutex> lock(buffersMutex);
+        buffers.push_back(unique_ptr<ThreadBuffer>(new ThreadBuffer()));
+        buffer = buffers.back().get();
+        buffer->thread = (int) buffers.size();
+        buffer->events.reserve(1 << 16);
+    }
+    return *buffer;
+}
+
+void Profiler::enable(bool enabled)
+{
+    Profiler::enabled.store(enabled, memory_order_relaxed);
+}
+
+void Profiler::record(const char *name, steady_clock::time_point start, steady_clock::time_point end)
+{
+    TraceEvent event;
+    event.name = name;
+    event.phase = 'X';
+    event.start = duration_cast<microseconds>(start - origin).count();
+    event.value = duration_cast<microseconds>(end - start).count();
+    threadBuffer().events.push_back(event);
+}
+
+void Profiler::addCount(const char *name, long long value)
+{
+    //Few counters per thread, a linear search is faster than a map
+    vector<pair<const char*, long long>> &counters = threadBuffer().counters;
+    for(vector<pair<const char*, long long>>::iterator it = counters.begin(); it != counters.end(); ++it)
+    {
+        if(it->first == name)
+        {
+            it->second += value;
+            return;
+        }
+    }
+    counters.push_back(make_pair(name, value));
+}
+
+void Profiler::sampleCounters()
+{
+    if(!isEnabled())
+        return;
+    ThreadBuffer &buffer = threadBuffer();
+    long long now = duration_cast<microseconds>(steady_clock::now() - origin).count();
+    for(vector<pair<const char*, long long>>::iterator it = buffer.counters.begin(); it != buffer.counters.end(); ++it)
+    {
+        TraceEvent event;
+        event.name = it->first;
+        event.phase = 'C';
+        event.start = now;
+        event.value = it->second;
+        buffer.events.push_back(event);
+    }
+}
+
+bool Profiler::writeTrace(const string &fileName)
+{
+    ofstream file(fileName.c_str());
+    if(!file.is_open())
+        return false;
+
+    lock_guard<mutex> lock(buffersMutex);
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    for(vector<unique_ptr<ThreadBuffer>>::iterator buffer = buffers.begin(); buffer != buffers.end(); ++buffer)
+    {
+        for(vector<TraceEvent>::iterator it = (*buffer)->events.begin(); it != (*buffer)->events.end(); ++it)
+        {
+            file << (first ? "\n" : ",\n") << "{\"name\":\"" << it->name << "\",\"ph\":\"" << it->phase
+                 << "\",\"pid\":1,\"tid\":" << (*buffer)->thread << ",\"ts\":" << it->start;
+            if(it->phase == 'X')
+                file << ",\"dur\":" << it->value << "}";
+            else
+                file << ",\"args\":{\"value\":" << it->value << "}}";
+            first = false;
+        }
+    }
+    file << "\n]}\n";
+    return true;
+}
+
+void Profiler::writeSummary(ostream &output)
+{
+    //Statistics of each timer and totals of the counters of all threads, by name
+    struct Statistics
+    {
+        long long calls;
+        long long total;
+        long long maximum;
+    };
+    map<string, Statistics> timers;
+    map<string, long long> counters;
+
+    lock_guard<mutex> lock(buffersMutex);
+    for(vector<unique_ptr<ThreadBuffer>>::iterator buffer = buffers.begin(); buffer != buffers.end(); ++buffer)
+    {
+        for(vector<TraceEvent>::iterator it = (*buffer)->events.begin(); it != (*buffer)->events.end(); ++it)
+        {
+            if(it->phase != 'X')
+                continue;
+            map<string, Statistics>::iterator timer = timers.find(it->name);
+            if(timer == timers.end())
+            {
+                Statistics statistics = {0, 0, 0};
+                timer = timers.insert(make_pair(string(it->name), statistics)).first;
+            }
+            timer->second.calls++;
+            timer->second.total += it->value;
+            timer->second.maximum = std::max(timer->second.maximum, it->value);
+        }
+        for(vector<pair<const char*, long long>>::iterator it = (*buffer)->counters.begin();
+            it != (*buffer)->counters.end(); ++it)
+            counters[it->first] += it->second;
+    }
+
+    output << "Stage, calls, total ms, mean ms, max ms\n";
+    for(map<string, Statistics>::iterator it = timers.begin(); it != timers.end(); ++it)
+    {
+        output << it->first << ", " << it->second.calls << ", " << it->second.total / 1000.0 << ", "
+               << it->second.total / 1000.0 / it->second.calls << ", " << it->second.maximum / 1000.0 << "\n";
+    }
+    output << "Counter, total\n";
+    for(map<string, long long>::iterator it = counters.begin(); it != counters.end(); ++it)
+        output << it->first << ", " << it->second << "\n";
+}
@@ -0,0 +1,71 @@
+//
+// Low overhead instrumentation of the detection: scoped timers and counters recorded in buffers of each thread,
+// exported as a Chrome trace (chrome://tracing, Perfetto) and as summary statistics. Everything is disabled by default
+// and then costs a single relaxed atomic load per timer or counter.
+//
+
+#ifndef DETECTION_PROFILER_H
+#define DETECTION_PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <ostream>
+
+class Profiler
+{
+public:
+    static void enable(bool enabled);
+    static inline bool isEnabled()
+    {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    //The names must be string literals, they are kept by their address
+    static void record(const char *name, std::chrono::steady_clock::time_point start,
+                       std::chrono::steady_clock::time_point end);
+    static inline void count(const char *name, long long value = 1)
+    {
+        if(isEnabled())
+            addCount(name, value);
+    }
+    //Adds the current value of the counters of this thread to the trace
+    static void sampleCounters();
+
+    //Only to be called when the instrumented threads are not running
+    static bool writeTrace(const std::string &fileName);
+    static void writeSummary(std::ostream &output);
+
+private:
+    static std::atomic<bool> enabled;
+    static void addCount(const char *name, long long value);
+};
+
+/*
+ * Records the time from its construction to its destruction
+ */
+class ScopedTimer
+{
+public:
+    inline explicit ScopedTimer(const char *name)
+    {
+        this->name = Profiler::isEnabled() ? name : NULL;
+        if(this->name != NULL)
+            start = std::chrono::steady_clock::now();
+    }
+
+    inline ~ScopedTimer()
+    {
+        if(name != NULL)
+            Profiler::record(name, start, std::chrono::steady_clock::now());
+    }
+
+private:
+    const char *name;
+    std::chrono::steady_clock::time_point start;
+
+    ScopedTimer(const ScopedTimer &);
+    ScopedTimer &operator=(const ScopedTimer &);
+};
+
+#endif //DETECTION_PROFILER_H
@@ -0,0 +1,300 @@
+//
+// Implementation of the QuantizedNet class
+//
+
+#include "QuantizedNet.h"
+#include <cmath>
+#include <string>
+#include <algorithm>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+using namespace std;
+using namespace caffe;
+
+//Number of int8 values processed by each step of the dot products
+static const int vectorWidth = 16;
+
+//Number of columns multiplied by all the rows of the weights before moving to the next ones, keeps them in the cache
+static const int columnTile = 64;
+
+static inline int8_t quantizeValue(float value, float inverseScale)
+{
+    int quantized = (int) lrintf(value * inverseScale);
+    return (int8_t) std::max(-127, std::min(127, quantized));
+}
+
+static inline int32_t dot(const int8_t *a, const int8_t *b, int length)
+{
+#ifdef __AVX2__
+    //Widen to 16 bits and multiply-add pairs into 32 bits accumulators, the length is a multiple of vectorWidth
+    __m256i accumulator = _mm256_setzero_si256();
+    for(int r = 0; r < length; r += vectorWidth)
+    {
+        __m256i x = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *) (a + r)));
+        __m256i y = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *) (b + r)));
+        accumulator = _mm256_add_epi32(accumulator, _mm256_madd_epi16(x, y));
+    }
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(accumulator), _mm256_extracti128_si256(accumulator, 1));
+    sum = _mm_hadd_epi32(sum, sum);
+    sum = _mm_hadd_epi32(sum, sum);
+    return _mm_cvtsi128_si32(sum);
+#else
+    //Simple enough for the compiler to vectorize it
+    int32_t sum = 0;
+    for(int r = 0; r < length; ++r)
+        sum += (int16_t) a[r] * (int16_t) b[r];
+    return sum;
+#endif
+}
+
+QuantizedNet::QuantizedNet(Net<float> *net)
+{
+    this->net = net;
+    ranges.assign(net->layers().size(), 0);
+}
+
+QuantizedNet::QuantizedNet(Net<float> *net, const QuantizedNet &weightsSource)
+{
+    //Both networks come from the same prototxt, so the layers have the same indexes
+    this->net = net;
+    ranges = weightsSource.ranges;
+    layers = weightsSource.layers;
+}
+
+void QuantizedNet::observe()
+{
+    //FP32 forward pass keeping the largest input seen by each layer which is going to be quantized
+    const vector<vector<Blob<float>*>> &bottoms = net->bottom_vecs();
+    for(int r = 0; r < (int) net->layers().size(); ++r)
+    {
+        QuantizedLayer layer;
+        if(describeLayer(r, layer))
+        {
+            const Blob<float> *input = bottoms[r][0];
+            const float *data = input->cpu_data();
+            for(int s = 0; s < input->count(); ++s)
+                ranges[r] = std::max(ranges[r], std::fabs(data[s]));
+        }
+        net->ForwardFromTo(r, r);
+    }
+}
+
+void QuantizedNet::quantize()
+{
+    vector<QuantizedLayer> *quantized = new vector<QuantizedLayer>();
+    for(int r = 0; r < (int) net->layers().size(); ++r)
+    {
+        QuantizedLayer layer;
+        if(!describeLayer(r, layer) || ranges[r] <= 0)
+            continue;
+
+        //Symmetric quantization of each output channel of the weights
+        const vector<shared_ptr<Blob<float>>> &blobs = net->layers()[r]->blobs();
+        const float *weights = blobs[0]->cpu_data();
+        layer.weights.assign((size_t) layer.outputs * layer.paddedLength, 0);
+        layer.weightScales.resize(layer.outputs);
+        for(int s = 0; s < layer.outputs; ++s)
+        {
+            const float *row = weights + (size_t) s * layer.length;
+            float maximum = 0;
+            for(int t = 0; t < layer.length; ++t)
+                maximum = std::max(maximum, std::fabs(row[t]));
+            float scale = maximum > 0 ? maximum / 127 : 1;
+            for(int t = 0; t < layer.length; ++t)
+                layer.weights[(size_t) s * layer.paddedLength + t] = quantizeValue(row[t], 1 / scale);
+            layer.weightScales[s] = scale;
+        }
+
+        if(blobs.size() > 1)
+            layer.bias.assign(blobs[1]->cpu_data(), blobs[1]->cpu_data() + layer.outputs);
+        else
+            layer.bias.assign(layer.outputs, 0);
+        layer.inputScale = ranges[r] / 127;
+        quantized->push_back(layer);
+    }
+    layers.reset(quantized);
+}
+
+void QuantizedNet::forward()
+{
+    vector<QuantizedLayer>::const_iterator next = layers->begin();
+    for(int r = 0; r < (int) net->layers().size(); ++r)
+    {
+        if(next != layers->end() && next->index == r)
+        {
+            forwardLayer(*next);
+            ++next;
+        }
+        else
+            net->ForwardFromTo(r, r);
+    }
+}
+
+int QuantizedNet::getQuantizedLayers() const
+{
+    return layers ? (int) layers->size() : 0;
+}
+
+bool QuantizedNet::describeLayer(int index, QuantizedLayer &layer) const
+{
+    const shared_ptr<Layer<float>> &netLayer = net->layers()[index];
+    const vector<Blob<float>*> &bottom = net->bottom_vecs()[index];
+    const vector<Blob<float>*> &top = net->top_vecs()[index];
+    string type = netLayer->type();
+    if(bottom.size() != 1 || top.size() != 1 || netLayer->blobs().empty())
+        return false;
+
+    const Blob<float> *weights = netLayer->blobs()[0].get();
+    layer.index = index;
+    if(type == "Convolution")
+    {
+        const ConvolutionParameter &convolution = netLayer->layer_param().convolution_param();
+        if(convolution.group() != 1 || weights->num_axes() != 4 || bottom[0]->num_axes() != 4)
+            return false;
+        layer.convolution = true;
+        layer.outputs = weights->shape(0);
+        layer.channels = weights->shape(1);
+        layer.kernelH = weights->shape(2);
+        layer.kernelW = weights->shape(3);
+        layer.padH = convolution.has_pad_h() ? convolution.pad_h() :
+                     convolution.pad_size() > 0 ? convolution.pad(0) : 0;
+        layer.padW = convolution.has_pad_w() ? convolution.pad_w() :
+                     convolution.pad_size() > 0 ? convolution.pad(convolution.pad_size() - 1) : 0;
+        layer.strideH = convolution.has_stride_h() ? convolution.stride_h() :
+                        convolution.stride_size() > 0 ? convolution.stride(0) : 1;
+        layer.strideW = convolution.has_stride_w() ? convolution.stride_w() :
+                        convolution.stride_size() > 0 ? convolution.stride(convolution.stride_size() - 1) : 1;
+        layer.length = layer.channels * layer.kernelH * layer.kernelW;
+
+        //Anything else changing the geometry (dilation) is left to caffe
+        int outputHeight = (bottom[0]->height() + 2 * layer.padH - layer.kernelH) / layer.strideH + 1;
+        int outputWidth = (bottom[0]->width() + 2 * layer.padW - layer.kernelW) / layer.strideW + 1;
+        if(bottom[0]->channels() != layer.channels || top[0]->height() != outputHeight ||
+           top[0]->width() != outputWidth)
+            return false;
+    }
+    else if(type == "InnerProduct")
+    {
+        const InnerProductParameter &innerProduct = netLayer->layer_param().inner_product_param();
+        if(innerProduct.axis() != 1 || weights->shape(0) != (int) innerProduct.num_output())
+            return false;
+        layer.convolution = false;
+        layer.outputs = innerProduct.num_output();
+        layer.length = weights->count() / layer.outputs;
+        layer.channels = layer.length;
+        layer.kernelH = layer.kernelW = 1;
+        layer.padH = layer.padW = 0;
+        layer.strideH = layer.strideW = 1;
+        if(bottom[0]->count(1) != layer.length)
+            return false;
+    }
+    else
+        return false;
+
+    layer.paddedLength = (layer.length + vectorWidth - 1) / vectorWidth * vectorWidth;
+    layer.inputScale = 0;
+    return true;
+}
+
+void QuantizedNet::forwardLayer(const QuantizedLayer &layer)
+{
+    const Blob<float> *bottom = net->bottom_vecs()[layer.index][0];
+    Blob<float> *top = net->top_vecs()[layer.index][0];
+    float *output = top->mutable_cpu_data();
+
+    if(layer.convolution)
+    {
+        //One matrix product per image of the batch: weights (outputs x length) by columns (length x pixels)
+        int pixels = top->height() * top->width();
+        for(int r = 0; r < bottom->num(); ++r)
+        {
+            quantizeConvolutionInput(layer, bottom->cpu_data() + bottom->offset(r), bottom->height(),
+                                     bottom->width(), top->height(), top->width());
+            multiply(layer.weights.data(), columns.data(), layer.outputs, pixels, layer.paddedLength,
+                     products.data());
+            float *image = output + top->offset(r);
+            for(int s = 0; s < layer.outputs; ++s)
+            {
+                float scale = layer.weightScales[s] * layer.inputScale;
+                for(int t = 0; t < pixels; ++t)
+                    image[s * pixels + t] = products[s * pixels + t] * scale + layer.bias[s];
+            }
+        }
+    }
+    else
+    {
+        int batch = bottom->shape(0);
+        quantizeInnerProductInput(layer, bottom->cpu_data(), batch);
+        multiply(layer.weights.data(), columns.data(), layer.outputs, batch, layer.paddedLength, products.data());
+        for(int s = 0; s < layer.outputs; ++s)
+        {
+            float scale = layer.weightScales[s] * layer.inputScale;
+            for(int r = 0; r < batch; ++r)
+                output[r * layer.outputs + s] = products[s * batch + r] * scale + layer.bias[s];
+        }
+    }
+}
+
+void QuantizedNet::quantizeConvolutionInput(const QuantizedLayer &layer, const float *input, int height, int width,
+                                            int outputHeight, int outputWidth)
+{
+    //Each output pixel gets a row with its receptive field in the order of the weights (channel, y, x), which makes
+    //the dot products contiguous in memory
+    float inverseScale = 1 / layer.inputScale;
+    columns.assign((size_t) outputHeight * outputWidth * layer.paddedLength, 0);
+    products.resize((size_t) outputHeight * outputWidth * layer.outputs);
+    int8_t *row = columns.data();
+    for(int y = 0; y < outputHeight; ++y)
+    {
+        for(int x = 0; x < outputWidth; ++x)
+        {
+            int8_t *value = row;
+            for(int c = 0; c < layer.channels; ++c)
+            {
+                const float *channel = input + (size_t) c * height * width;
+                for(int ky = 0; ky < layer.kernelH; ++ky)
+                {
+                    int inputY = y * layer.strideH - layer.padH + ky;
+                    for(int kx = 0; kx < layer.kernelW; ++kx)
+                    {
+                        int inputX = x * layer.strideW - layer.padW + kx;
+                        if(inputY >= 0 && inputY < height && inputX >= 0 && inputX < width)
+                            *value = quantizeValue(channel[inputY * width + inputX], inverseScale);
+                        ++value;
+                    }
+                }
+            }
+            row += layer.paddedLength;
+        }
+    }
+}
+
+void QuantizedNet::quantizeInnerProductInput(const QuantizedLayer &layer, const float *input, int batch)
+{
+    float inverseScale = 1 / layer.inputScale;
+    columns.assign((size_t) batch * layer.paddedLength, 0);
+    products.resize((size_t) batch * layer.outputs);
+    for(int r = 0; r < batch; ++r)
+    {
+        for(int s = 0; s < layer.length; ++s)
+            columns[(size_t) r * layer.paddedLength + s] = quantizeValue(input[(size_t) r * layer.length + s],
+                                                                         inverseScale);
+    }
+}
+
+void QuantizedNet::multiply(const int8_t *weights, const int8_t *columns, int rows, int columnCount, int length,
+                            int32_t *output)
+{
+    for(int tile = 0; tile < columnCount; tile += columnTile)
+    {
+        int end = std::min(tile + columnTile, columnCount);
+        for(int r = 0; r < rows; ++r)
+        {
+            const int8_t *row = weights + (size_t) r * length;
+            for(int s = tile; s < end; ++s)
+                output[(size_t) r * columnCount + s] = dot(row, columns + (size_t) s * length, length);
+        }
+    }
+}
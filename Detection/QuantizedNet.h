@@ -0,0 +1,66 @@
+//
+// INT8 inference for a caffe network on the CPU. The weights of the Convolution and InnerProduct layers are quantized
+// per output channel after training, and their inputs per layer with the ranges observed in a calibration pass over
+// sample crops. Those layers run as integer matrix products, the rest of the layers use the caffe implementation, and
+// the activations between layers stay in float so the output blobs of the network are the same as in FP32.
+//
+
+#ifndef DETECTION_QUANTIZEDNET_H
+#define DETECTION_QUANTIZEDNET_H
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <caffe/caffe.hpp>
+
+/*
+ * Quantized weights of a Convolution or InnerProduct layer
+ */
+struct QuantizedLayer
+{
+    int index;
+    bool convolution;
+    int outputs;
+    int channels;
+    int kernelH;
+    int kernelW;
+    int padH;
+    int padW;
+    int strideH;
+    int strideW;
+    //Length of the dot products, rows of the weights are padded with zeros up to a multiple of the vector width
+    int length;
+    int paddedLength;
+    std::vector<int8_t> weights;
+    std::vector<float> weightScales;
+    std::vector<float> bias;
+    float inputScale;
+};
+
+class QuantizedNet
+{
+public:
+    QuantizedNet(caffe::Net<float> *net);
+    QuantizedNet(caffe::Net<float> *net, const QuantizedNet &weightsSource);
+    void observe();
+    void quantize();
+    void forward();
+    int getQuantizedLayers() const;
+
+private:
+    caffe::Net<float> *net;
+    std::vector<float> ranges;
+    std::shared_ptr<const std::vector<QuantizedLayer>> layers;
+    std::vector<int8_t> columns;
+    std::vector<int32_t> products;
+
+    bool describeLayer(int index, QuantizedLayer &layer) const;
+    void forwardLayer(const QuantizedLayer &layer);
+    void quantizeConvolutionInput(const QuantizedLayer &layer, const float *input, int height, int width,
+                                  int outputHeight, int outputWidth);
+    void quantizeInnerProductInput(const QuantizedLayer &layer, const float *input, int batch);
+    static void multiply(const int8_t *weights, const int8_t *columns, int rows, int columnCount, int length,
+                         int32_t *output);
+};
+
+#endif //DETECTION_QUANTIZEDNET_H
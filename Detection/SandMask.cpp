@@ -0,0 +1,43 @@
+//
+// Implementation of the SandMask class
+//
+
+#include "SandMask.h"
+#include <opencv2/imgproc.hpp>
+#include "Profiler.h"
+
+using namespace cv;
+
+SandMask::SandMask(const Parameters &parameters)
+{
+    lower = Scalar(parameters.sandHueMin, 0, parameters.sandValueMin);
+    upper = Scalar(parameters.sandHueMax, parameters.sandSaturationMax, 255);
+    scale = parameters.sandMaskScale;
+    sandFraction = 1;
+
+    //Tracks and nests are darker than the sand around them, closing the mask keeps them inside
+    closeKernel = getStructuringElement(MORPH_ELLIPSE, Size(9, 9));
+}
+
+Mat SandMask::compute(const Mat &image)
+{
+    ScopedTimer timer("sand mask");
+    //The thresholds only need the colour of the ground, so they are applied over a reduced copy
+    Mat reduced, hsv, sand, mask;
+    if(scale < 1)
+        resize(image, reduced, Size(), scale, scale, INTER_AREA);
+    else
+        reduced = image;
+    cvtColor(reduced, hsv, COLOR_BGR2HSV);
+    inRange(hsv, lower, upper, sand);
+    morphologyEx(sand, sand, MORPH_CLOSE, closeKernel);
+    sandFraction = (float) countNonZero(sand) / sand.total();
+
+    resize(sand, mask, image.size(), 0, 0, INTER_NEAREST);
+    return mask;
+}
+
+float SandMask::getSandFraction() const
+{
+    return sandFraction;
+}
@@ -0,0 +1,28 @@
+//
+// Pixel-level region of interest ahead of the selective search. Sand is separated from the sea, the vegetation and
+// anything else where a turtle track can not be with thresholds over the HSV colour of a reduced copy of the image,
+// and the proposals mostly outside the resulting mask are skipped before they reach the ConvNet.
+//
+
+#ifndef DETECTION_SANDMASK_H
+#define DETECTION_SANDMASK_H
+
+#include <opencv2/core.hpp>
+#include "Parameters.h"
+
+class SandMask
+{
+public:
+    SandMask(const Parameters &parameters);
+    cv::Mat compute(const cv::Mat &image);
+    float getSandFraction() const;
+
+private:
+    cv::Scalar lower;
+    cv::Scalar upper;
+    float scale;
+    float sandFraction;
+    cv::Mat closeKernel;
+};
+
+#endif //DETECTION_SANDMASK_H
@@ -0,0 +1,62 @@
+//
+// Created by ricardo_8990 on 8/19/15.
+//
+
+#include "SelectiveMethod.h"
+#include <algorithm>
+#include <cmath>
+#include <opencv2/imgproc.hpp>
+
+using namespace cv;
+
+SelectiveMethod::SelectiveMethod(const Parameters &parameters)
+{
+    this->parameters = parameters;
+}
+
+void SelectiveMethod::initializeSlideWindow(cv::Mat image)
+{
+    //The segmentation and the grouping run on the reduced image, so the sizes in pixels are reduced as well
+    Mat proposalImage = image;
+    if(!reduced.empty())
+        proposalImage = reduced;
+    else if(parameters.proposalScale < 1)
+        resize(image, proposalImage, Size(), parameters.proposalScale, parameters.proposalScale, INTER_AREA);
+    reduced.release();
+    imageSize = image.size();
+    scaleX = (double) proposalImage.cols / image.cols;
+    scaleY = (double) proposalImage.rows / image.rows;
+
+    int minSize = std::max(1, (int) lround(parameters.minSize * scaleX * scaleY));
+    Size minRegionSize(std::max(1, (int) lround(parameters.minRegionWidth * scaleX)),
+                       std::max(1, (int) lround(parameters.minRegionHeight * scaleY)));
+    Size maxRegionSize((int) lround(parameters.maxRegionWidth * scaleX),
+                       (int) lround(parameters.maxRegionHeight * scaleY));
+    method = new ssm::SelectiveSearchMethod(proposalImage, parameters.sigma, parameters.k, minSize,
+                                            parameters.maxRegions, minRegionSize, maxRegionSize);
+}
+
+cv::Rect SelectiveMethod::getProposedRegion()
+{
+    Rect region = method->getProposedRegion();
+    if((region.height == 0 && region.width == 0) || (scaleX == 1 && scaleY == 1))
+        return region;
+
+    //Map the box back to the full resolution, growing it to whole pixels of the original image
+    int x = (int) std::floor(region.x / scaleX);
+    int y = (int) std::floor(region.y / scaleY);
+    int right = std::min(imageSize.width, (int) std::ceil((region.x + region.width) / scaleX));
+    int bottom = std::min(imageSize.height, (int) std::ceil((region.y + region.height) / scaleY));
+    return Rect(x, y, right - x, bottom - y);
+}
+
+void SelectiveMethod::clear()
+{
+    method->clear();
+    delete method;
+}
+
+void SelectiveMethod::setReducedImage(cv::Mat reduced)
+{
+    this->reduced = reduced;
+}
@@ -2,22 +2,29 @@
 // Created by ricardo_8990 on 8/19/15.
 //
 
-#ifndef TRACKING_SELECTIVEMETHOD_H
-#define TRACKING_SELECTIVEMETHOD_H
+#ifndef DETECTION_SELECTIVEMETHOD_H
+#define DETECTION_SELECTIVEMETHOD_H
 
 #include "ISlideMethod.h"
+#include "Parameters.h"
 #include "SelectiveSearchMethod/SelectiveSearchMethod.h"
 
 class SelectiveMethod : public ISlideMethod
 {
 public:
-    SelectiveMethod();
+    SelectiveMethod(const Parameters &parameters);
     void initializeSlideWindow(cv::Mat image);
     cv::Rect getProposedRegion();
     void clear();
+    void setReducedImage(cv::Mat reduced);
 
 private:
     ssm::SelectiveSearchMethod *method;
+    Parameters parameters;
+    cv::Mat reduced;
+    cv::Size imageSize;
+    double scaleX;
+    double scaleY;
 };
 
-#endif //TRACKING_SELECTIVEMETHOD_H
+#endif //DETECTION_SELECTIVEMETHOD_H
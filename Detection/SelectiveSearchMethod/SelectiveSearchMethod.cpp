@@ -5,13 +5,20 @@
 #include "SelectiveSearchMethod.h"
 #include <opencv2/imgproc/types_c.h>
 #include <opencv2/imgproc.hpp>
+#include "../Profiler.h"
+#include "../TaskPool.h"
 
 using namespace ssm;
 using namespace cv;
 using namespace std;
 
-SelectiveSearchMethod::SelectiveSearchMethod(Mat inputImage, float sigma, int k, int minSize)
+SelectiveSearchMethod::SelectiveSearchMethod(Mat inputImage, float sigma, int k, int minSize, int maxRegions,
+                                             Size minRegionSize, Size maxRegionSize)
 {
+    ScopedTimer timer("selective search");
+    this->minRegionSize = minRegionSize;
+    this->maxRegionSize = maxRegionSize;
+
     //Change colour space to HSV
     Mat image2process;
     float imageSize = inputImage.cols * inputImage.rows;
@@ -23,12 +30,20 @@ SelectiveSearchMethod::SelectiveSearchMethod(Mat inputImage, float sigma, int k,
 
     //Obtain initial regions
     int numCcs;
-    double *initialRegions = segment_image(imageFormat, sigma, k, minSize, &numCcs);
+    double *initialRegions;
+    {
+        ScopedTimer segmentTimer("segmentation");
+        initialRegions = segment_image(imageFormat, sigma, k, minSize, &numCcs);
+    }
     Neighbourhood *neighbourhood = new Neighbourhood();
     regions = universeToRegions(initialRegions, inputImage.cols, inputImage.rows, neighbourhood);
+    Profiler::count("initial regions", numCcs);
 
     //Calculate histograms for each regions
-    calculateHistograms(image2process);
+    {
+        ScopedTimer histogramTimer("histograms");
+        calculateHistograms(image2process);
+    }
 
     //Similarity Set S = 0
     std::vector<similarity> similarities;
@@ -44,7 +59,9 @@ SelectiveSearchMethod::SelectiveSearchMethod(Mat inputImage, float sigma, int k,
     std::sort(similarities.begin(), similarities.end());
 
     //Iterate to join regions
-    while (!similarities.empty() && regions.size() <= 2000)
+    ScopedTimer groupingTimer("grouping");
+    int merges = 0;
+    while (!similarities.empty() && regions.size() <= (unsigned long) maxRegions)
     {
         similarity maxSim = similarities.back();
         numCcs++;
@@ -77,7 +94,9 @@ SelectiveSearchMethod::SelectiveSearchMethod(Mat inputImage, float sigma, int k,
         calculateSimilarities(imageSize, similarities, numCcs, neighbourhood->neighbours[numCcs]);
 
         std::sort(similarities.begin(), similarities.end());
+        merges++;
     }
+    Profiler::count("merges", merges);
 
     delete neighbourhood;
     delete initialRegions;
@@ -98,11 +117,34 @@ Rect SelectiveSearchMethod::getProposedRegion()
         Region region = globalIt->second;
         element = cv::Rect(region.left, region.top, region.right - region.left, region.bottom - region.top);
         ++globalIt;
-    } while(element.width < 50 || element.height < 50 || element.width > 347 || element.height > 429);
+    } while(element.width < minRegionSize.width || element.height < minRegionSize.height ||
+            element.width > maxRegionSize.width || element.height > maxRegionSize.height);
 
     return element;
 }
 
+Mat SelectiveSearchMethod::segment(Mat inputImage, float sigma, int k, int minSize)
+{
+    //Same colour space and segmentation as the constructor
+    Mat image2process;
+    cvtColor(inputImage, image2process, CV_RGB2HSV, 0);
+    image<rgb> *imageFormat = cvtMatToImage(image2process);
+    int numCcs;
+    double *segIndices = segment_image(imageFormat, sigma, k, minSize, &numCcs);
+
+    //The labels are stored by columns
+    Mat labels(inputImage.rows, inputImage.cols, CV_32S);
+    for (int r = 0; r < inputImage.rows; ++r)
+    {
+        for (int s = 0; s < inputImage.cols; ++s)
+            labels.at<int>(r, s) = (int) segIndices[s * inputImage.rows + r];
+    }
+
+    delete[] segIndices;
+    delete imageFormat;
+    return labels;
+}
+
 image<rgb> *SelectiveSearchMethod::cvtMatToImage(cv::Mat inputImage)
 {
     int noCols = inputImage.cols;
@@ -191,17 +233,24 @@ float SelectiveSearchMethod::getSimilarity(int a, int b, float sizeImage)
 
 void SelectiveSearchMethod::calculateHistograms(Mat inputImage)
 {
+    //The initial regions hold their own points, so each region is filled by a single task
+    vector<Region *> initialRegions;
     for(unordered_map<int, Region>::iterator r = regions.begin(); r != regions.end(); ++r)
+        initialRegions.push_back(&r->second);
+    TaskPool::parallelFor(0, (int) initialRegions.size(), 64, [&](int first, int last)
     {
-        vector<Point> points = getPointsFromRegion(r->first);
-        for(vector<Point>::iterator s = points.begin(); s != points.end(); ++s)
+        for(int r = first; r < last; ++r)
         {
-            Vec3b pixel = inputImage.at<Vec3b>(*s);
-            r->second.histogram.addValue(pixel);
+            Region &region = *initialRegions[r];
+            for(vector<Point>::iterator s = region.points.begin(); s != region.points.end(); ++s)
+            {
+                Vec3b pixel = inputImage.at<Vec3b>(*s);
+                region.histogram.addValue(pixel);
+            }
+            //Normalize
+            region.histogram.normalize();
         }
-        //Normalize
-        r->second.histogram.normalize();
-    }
+    }, "region histograms");
 }
 
 void SelectiveSearchMethod::calculateSimilarities(float imageSize,
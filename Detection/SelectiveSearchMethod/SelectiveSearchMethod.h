@@ -5,8 +5,8 @@
 // the OpenCV community.
 //
 
-#ifndef TRACKING_SELECTIVESEARCHMETHOD_H
-#define TRACKING_SELECTIVESEARCHMETHOD_H
+#ifndef DETECTION_SELECTIVESEARCHMETHOD_H
+#define DETECTION_SELECTIVESEARCHMETHOD_H
 
 #include <opencv2/core.hpp>
 #include "segment/image.h"
@@ -159,8 +159,11 @@ namespace ssm
     {
     public:
 
-        SelectiveSearchMethod(cv::Mat inputImage, float sigma, int k, int minSize);
+        SelectiveSearchMethod(cv::Mat inputImage, float sigma, int k, int minSize, int maxRegions,
+                              cv::Size minRegionSize, cv::Size maxRegionSize);
         cv::Rect getProposedRegion();
+        //Label of the initial region of each pixel, as computed before grouping them
+        static cv::Mat segment(cv::Mat inputImage, float sigma, int k, int minSize);
         inline void clear()
         {
             regions.clear();
@@ -192,9 +195,11 @@ namespace ssm
     private:
         std::unordered_map<int, Region> regions;
         std::unordered_map<int, Region>::iterator globalIt;
+        cv::Size minRegionSize;
+        cv::Size maxRegionSize;
 
     private:
-        image<rgb> *cvtMatToImage(cv::Mat inputImage);
+        static image<rgb> *cvtMatToImage(cv::Mat inputImage);
 
         std::unordered_map<int, Region> universeToRegions(double *segIndices, int width, int height, Neighbourhood* neighbourhood);
 
@@ -213,4 +218,4 @@ namespace ssm
     };
 }
 
-#endif //TRACKING_SELECTIVESEARCHMETHOD_H
+#endif //DETECTION_SELECTIVESEARCHMETHOD_H
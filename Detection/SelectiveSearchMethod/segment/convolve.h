@@ -25,15 +25,17 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
 #include <algorithm>
 #include <cmath>
 #include "image.h"
+#include "../../TaskPool.h"
 
-/* convolve src with mask.  dst is flipped! */
+/* convolve src with mask.  dst is flipped! the rows are convolved in parallel */
 static void convolve_even(image<float> *src, image<float> *dst, 
 			  std::vector<float> &mask) {
   int width = src->width();
   int height = src->height();
   int len = mask.size();
 
-  for (int y = 0; y < height; y++) {
+  TaskPool::parallelFor(0, height, 32, [&](int first, int last) {
+  for (int y = first; y < last; y++) {
     for (int x = 0; x < width; x++) {
       float sum = mask[0] * imRef(src, x, y);
       for (int i = 1; i < len; i++) {
@@ -44,6 +46,7 @@ static void convolve_even(image<float> *src, image<float> *dst,
       imRef(dst, y, x) = sum;
     }
   }
+  }, "convolve rows");
 }
 
 /* convolve src with mask.  dst is flipped! */
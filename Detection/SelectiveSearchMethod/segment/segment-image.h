@@ -20,10 +20,12 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
 #define SEGMENT_IMAGE
 
 #include <cstdlib>
+#include <vector>
 #include "image.h"
 #include "misc.h"
 #include "filter.h"
 #include "segment-graph.h"
+#include "../../TaskPool.h"
 
 // random color
 inline rgb random_rgb(){
@@ -73,17 +75,34 @@ inline double *segment_image(image<rgb> *im, float sigma, float c, int min_size,
       imRef(b, x, y) = imRef(im, x, y).b;
     }
     }
-    image<float> *smooth_r = smooth(r, sigma);
-    image<float> *smooth_g = smooth(g, sigma);
-    image<float> *smooth_b = smooth(b, sigma);
+    // the channels are smoothed in parallel, and the rows of each one too
+    image<float> *channels[3] = { r, g, b };
+    image<float> *smoothed[3];
+    TaskPool::parallelFor(0, 3, 1, [&](int first, int last) {
+      for (int i = first; i < last; i++)
+        smoothed[i] = smooth(channels[i], sigma);
+    }, "smooth channel");
+    image<float> *smooth_r = smoothed[0];
+    image<float> *smooth_g = smoothed[1];
+    image<float> *smooth_b = smoothed[2];
     delete r;
     delete g;
     delete b;
 
-    // build graph
+    // build graph, the rows in parallel from the position of their first edge when they are built in order
     edge *edges = new edge[width*height*4];
-    int num = 0;
+    std::vector<int> row_start(height + 1, 0);
     for (int y = 0; y < height; y++) {
+      int count = width-1;
+      if (y < height-1)
+        count += width + width-1;
+      if (y > 0)
+        count += width-1;
+      row_start[y+1] = row_start[y] + count;
+    }
+    TaskPool::parallelFor(0, height, 32, [&](int first, int last) {
+    for (int y = first; y < last; y++) {
+    int num = row_start[y];
     for (int x = 0; x < width; x++) {
       if (x < width-1) {
     edges[num].a = y * width + x;
@@ -114,6 +133,8 @@ inline double *segment_image(image<rgb> *im, float sigma, float c, int min_size,
       }
     }
     }
+    }, "build edges");
+    int num = row_start[height];
     delete smooth_r;
     delete smooth_g;
     delete smooth_b;
@@ -38,7 +38,20 @@ int main(int argc, char **argv) {
 	
   printf("processing\n");
   int num_ccs; 
-  image<rgb> *seg = segment_image(input, sigma, k, min_size, &num_ccs); 
+  double *labels = segment_image(input, sigma, k, min_size, &num_ccs); 
+
+  // random color for each component, the labels are stored column by column
+  int width = input->width();
+  int height = input->height();
+  rgb *colors = new rgb[num_ccs + 1];
+  for (int i = 0; i <= num_ccs; i++)
+    colors[i] = random_rgb();
+  image<rgb> *seg = new image<rgb>(width, height);
+  for (int y = 0; y < height; y++)
+    for (int x = 0; x < width; x++)
+      imRef(seg, x, y) = colors[(int) labels[x * height + y]];
+  delete [] colors;
+  delete [] labels;
   savePPM(seg, argv[5]);
 
   printf("got %d components\n", num_ccs);
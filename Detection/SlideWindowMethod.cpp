@@ -7,6 +7,8 @@
 void SlideWindowMethod::initializeSlideWindow(cv::Mat image)
 {
     this->image = image;
+    currentRow = 0;
+    currentColumn = 0;
 }
 
 cv::Rect SlideWindowMethod::getProposedRegion()
@@ -2,8 +2,8 @@
 // Created by ricardo_8990 on 8/19/15.
 //
 
-#ifndef TRACKING_SLIDEWINDOWMETHOD_H
-#define TRACKING_SLIDEWINDOWMETHOD_H
+#ifndef DETECTION_SLIDEWINDOWMETHOD_H
+#define DETECTION_SLIDEWINDOWMETHOD_H
 
 #include "ISlideMethod.h"
 
@@ -22,4 +22,4 @@ private:
     cv::Mat image;
 };
 
-#endif //TRACKING_SLIDEWINDOWMETHOD_H
+#endif //DETECTION_SLIDEWINDOWMETHOD_H
@@ -0,0 +1,109 @@
+//
+// Bounded lock-free queue for a single producer thread and a single consumer thread. The producer only writes the
+// tail and the consumer only writes the head, so the acquire/release pairs on them are enough to hand the elements
+// over without locks. A thread which finds the queue empty or full can instead sleep until the other one pops or
+// pushes, the mutex is only taken when one of them is sleeping.
+//
+
+#ifndef DETECTION_SPSCQUEUE_H
+#define DETECTION_SPSCQUEUE_H
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <mutex>
+#include <condition_variable>
+
+template <typename T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(size_t capacity) : buffer(capacity + 1), head(0), tail(0), producerWaiting(false),
+                                          consumerWaiting(false)
+    {
+    }
+
+    //Returns false when the queue is full
+    bool push(const T &element)
+    {
+        size_t current = tail.load(std::memory_order_relaxed);
+        size_t next = (current + 1) % buffer.size();
+        if(next == head.load(std::memory_order_acquire))
+            return false;
+        buffer[current] = element;
+        tail.store(next, std::memory_order_release);
+        wake(consumerWaiting);
+        return true;
+    }
+
+    //Returns false when the queue is empty
+    bool pop(T &element)
+    {
+        size_t current = head.load(std::memory_order_relaxed);
+        if(current == tail.load(std::memory_order_acquire))
+            return false;
+        element = buffer[current];
+        buffer[current] = T();
+        head.store((current + 1) % buffer.size(), std::memory_order_release);
+        wake(producerWaiting);
+        return true;
+    }
+
+    //Sleeps while the queue is full
+    void waitPush(const T &element)
+    {
+        while(!push(element))
+            wait(producerWaiting, [this]() { return !isFull(); });
+    }
+
+    //Sleeps while the queue is empty
+    void waitPop(T &element)
+    {
+        while(!pop(element))
+            wait(consumerWaiting, [this]() { return !isEmpty(); });
+    }
+
+private:
+    std::vector<T> buffer;
+    //Each index in its own cache line, such that the two threads do not invalidate each other
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) std::atomic<size_t> tail;
+    std::atomic<bool> producerWaiting;
+    std::atomic<bool> consumerWaiting;
+    std::mutex waitMutex;
+    std::condition_variable waitCondition;
+
+    bool isEmpty() const
+    {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+    bool isFull() const
+    {
+        return (tail.load(std::memory_order_acquire) + 1) % buffer.size() == head.load(std::memory_order_acquire);
+    }
+
+    //The fences order the flag of the sleeping thread and the index of the other one, such that either the sleeping
+    //thread sees the new index before it sleeps or the other one sees the flag and wakes it
+    template <typename Predicate>
+    void wait(std::atomic<bool> &waiting, Predicate ready)
+    {
+        std::unique_lock<std::mutex> lock(waitMutex);
+        waiting.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        waitCondition.wait(lock, ready);
+        waiting.store(false, std::memory_order_relaxed);
+    }
+
+    void wake(std::atomic<bool> &waiting)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(waiting.load(std::memory_order_relaxed))
+        {
+            std::lock_guard<std::mutex> lock(waitMutex);
+            waitCondition.notify_all();
+        }
+    }
+};
+
+#endif //DETECTION_SPSCQUEUE_H
@@ -0,0 +1,227 @@
+//
+// Implementation of the TaskPool class
+//
+
+#include "TaskPool.h"
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <algorithm>
+#include "Profiler.h"
+
+using namespace std;
+
+/*
+ * Loop waiting for its chunks, the thread running the last one signals it once nothing is left to steal
+ */
+struct Loop
+{
+    atomic<int> pending;
+    mutex doneMutex;
+    condition_variable doneCondition;
+    bool done;
+};
+
+/*
+ * Chunk of a loop
+ */
+struct Task
+{
+    const function<void(int, int)> *body;
+    int begin;
+    int end;
+    const char *name;
+    Loop *loop;
+};
+
+/*
+ * Tasks pushed by a thread, the first queue is shared by the threads which are not part of the pool
+ */
+struct TaskQueue
+{
+    mutex queueMutex;
+    deque<Task> tasks;
+};
+
+static mutex configureMutex;
+static atomic<bool> configured(false);
+static atomic<int> threadCount(1);
+static vector<unique_ptr<TaskQueue>> queues;
+static vector<thread> workers;
+static atomic<bool> stopping(false);
+static mutex sleepMutex;
+static condition_variable sleepCondition;
+//Incremented under sleepMutex after tasks are pushed, the threads of the pool sleep until it changes
+static atomic<unsigned long> generation(0);
+static thread_local int queueIndex = 0;
+
+static void stopWorkers()
+{
+    {
+        lock_guard<mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    sleepCondition.notify_all();
+    for(vector<thread>::iterator it = workers.begin(); it != workers.end(); ++it)
+        it->join();
+    workers.clear();
+    stopping = false;
+}
+
+/*
+ * Joins the threads of the pool when the program ends, it is destroyed before the queues
+ */
+static struct PoolShutdown
+{
+    ~PoolShutdown()
+    {
+        lock_guard<mutex> lock(configureMutex);
+        stopWorkers();
+    }
+} poolShutdown;
+
+static bool takeTask(int index, Task &task)
+{
+    //The newest task of the own queue, whose data is still in the cache of this core
+    {
+        TaskQueue &own = *queues[index];
+        lock_guard<mutex> lock(own.queueMutex);
+        if(!own.tasks.empty())
+        {
+            task = own.tasks.back();
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    //Otherwise the oldest task of another queue
+    for(unsigned long r = 1; r < queues.size(); ++r)
+    {
+        TaskQueue &other = *queues[(index + r) % queues.size()];
+        lock_guard<mutex> lock(other.queueMutex);
+        if(!other.tasks.empty())
+        {
+            task = other.tasks.front();
+            other.tasks.pop_front();
+            Profiler::count("tasks stolen");
+            return true;
+        }
+    }
+    return false;
+}
+
+static void runTask(const Task &task)
+{
+    {
+        ScopedTimer timer(task.name);
+        (*task.body)(task.begin, task.end);
+    }
+
+    //The loop may return as soon as done is set, so the task does not touch it afterwards
+    Loop &loop = *task.loop;
+    if(loop.pending.fetch_sub(1, memory_order_acq_rel) == 1)
+    {
+        lock_guard<mutex> lock(loop.doneMutex);
+        loop.done = true;
+        loop.doneCondition.notify_all();
+    }
+}
+
+static void workerLoop(int index)
+{
+    //The generation is read before looking for tasks, so the tasks pushed after it was read change it and wake the
+    //thread, while the ones pushed before are found
+    queueIndex = index;
+    Task task;
+    while(!stopping)
+    {
+        unsigned long seen = generation.load();
+        if(takeTask(index, task))
+        {
+            runTask(task);
+            continue;
+        }
+        unique_lock<mutex> lock(sleepMutex);
+        sleepCondition.wait(lock, [seen]() { return stopping || generation.load() != seen; });
+    }
+}
+
+/*
+ * Starts the threads of the pool, with configureMutex held
+ */
+static void startPool(int threads)
+{
+    stopWorkers();
+    int count = threads > 0 ? threads : std::max(1, (int) thread::hardware_concurrency());
+
+    //The calling threads run tasks too, so the pool starts one thread less
+    queues.clear();
+    for(int r = 0; r < count; ++r)
+        queues.push_back(unique_ptr<TaskQueue>(new TaskQueue()));
+    for(int r = 1; r < count; ++r)
+        workers.push_back(thread(workerLoop, r));
+    threadCount = count;
+    configured = true;
+}
+
+void TaskPool::configure(int threads)
+{
+    lock_guard<mutex> lock(configureMutex);
+    startPool(threads);
+}
+
+int TaskPool::getThreads()
+{
+    //The pool uses every core unless it was configured before the first loop, the first of the threads reaching it
+    //starts it and the others wait for it
+    if(!configured)
+    {
+        lock_guard<mutex> lock(configureMutex);
+        if(!configured)
+            startPool(0);
+    }
+    return threadCount;
+}
+
+void TaskPool::parallelFor(int begin, int end, int grain, const function<void(int, int)> &body, const char *name)
+{
+    grain = std::max(grain, 1);
+    if(end - begin <= grain || getThreads() <= 1)
+    {
+        ScopedTimer timer(name);
+        body(begin, end);
+        return;
+    }
+
+    Loop loop;
+    loop.pending = 0;
+    loop.done = false;
+    int index = queueIndex;
+    {
+        TaskQueue &own = *queues[index];
+        lock_guard<mutex> lock(own.queueMutex);
+        for(int first = begin; first < end; first += grain)
+        {
+            Task task = { &body, first, std::min(end, first + grain), name, &loop };
+            own.tasks.push_back(task);
+            loop.pending++;
+        }
+    }
+    {
+        lock_guard<mutex> lock(sleepMutex);
+        generation++;
+    }
+    sleepCondition.notify_all();
+
+    //The calling thread runs tasks of this loop or of any other one, then sleeps until the chunks of this loop which
+    //other threads are running are finished
+    Task task;
+    while(loop.pending.load(memory_order_acquire) > 0 && takeTask(index, task))
+        runTask(task);
+    unique_lock<mutex> lock(loop.doneMutex);
+    loop.doneCondition.wait(lock, [&loop]() { return loop.done; });
+}
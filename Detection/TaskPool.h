@@ -0,0 +1,27 @@
+//
+// Work-stealing pool of threads shared by the whole program, such that the segmentation, the grouping of the regions,
+// the preprocessing of the crops and the pipelines of the programs do not each start their own threads. Each thread
+// of the pool has its own queue of tasks: it takes its newest task first and steals the oldest task of another queue
+// when its own is empty. A thread waiting for the tasks of a loop runs tasks meanwhile, so loops can be nested. Each
+// task is recorded by the Profiler under the name of its loop, which gives the statistics of the tasks in the summary.
+//
+
+#ifndef DETECTION_TASKPOOL_H
+#define DETECTION_TASKPOOL_H
+
+#include <functional>
+
+class TaskPool
+{
+public:
+    //Number of threads running tasks, including the ones calling the loops, 0 is the number of cores. Only to be
+    //called when no loop is running
+    static void configure(int threads);
+    static int getThreads();
+
+    //Runs body(first, last) over chunks of grain elements of [begin, end), the name must be a string literal
+    static void parallelFor(int begin, int end, int grain, const std::function<void(int, int)> &body,
+                            const char *name);
+};
+
+#endif //DETECTION_TASKPOOL_H
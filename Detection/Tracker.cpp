@@ -0,0 +1,479 @@
+//
+// Created by ricardo_8990 on 8/19/15.
+// Implementation of the Tracker class
+//
+
+#include "Tracker.h"
+#include <algorithm>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/video/tracking.hpp>
+#include "SlideWindowMethod.h"
+#include "SelectiveMethod.h"
+#include "Profiler.h"
+
+using std::string;
+using std::vector;
+using namespace cv;
+
+/*
+ * The frames are scored on the calling thread, so the classifier does not need its scoring thread
+ */
+static Parameters withoutPipeline(Parameters parameters)
+{
+    parameters.pipeline = false;
+    return parameters;
+}
+
+Tracker::Tracker(const string &model, const string &weights, const Parameters &parameters) :
+        classifier(model, weights, withoutPipeline(parameters)), sandMask(parameters)
+{
+    initialize(parameters);
+}
+
+Tracker::Tracker(const Tracker &weightsSource, const Parameters &parameters) :
+        classifier(weightsSource.classifier, withoutPipeline(parameters)), sandMask(parameters)
+{
+    //Classifier with its own activations sharing the weights of the other tracker
+    initialize(parameters);
+}
+
+void Tracker::initialize(const Parameters &parameters)
+{
+    //Get the geometry of the model
+    geometry = classifier.getInputSize();
+
+    nextId = 0;
+    current = 0;
+    this->parameters = parameters;
+    unscoredFraction = 0;
+}
+
+int Tracker::Track(const cv::Mat &inputImage)
+{
+    ScopedTimer timer("track frame");
+    deadline = std::chrono::steady_clock::time_point::max();
+    if(parameters.frameBudget > 0)
+        deadline = std::chrono::steady_clock::now() +
+                   std::chrono::microseconds((long long) (parameters.frameBudget * 1000));
+    proposedRegions = 0;
+    unscoredRegions = 0;
+    prepareFrame(inputImage);
+
+    //If there is no previous nests, classify the whole image and return. The proposals carried from the previous
+    //frame are proposed again with it, so they are dropped instead of being scored twice
+    if(nests.empty())
+    {
+        carried.clear();
+        int nestsNumber = classifyImage(inputImage);
+        unscoredFraction = proposedRegions > 0 ? (float) unscoredRegions / proposedRegions : 0;
+        frames[current].image.release();
+        current = 1 - current;
+        Profiler::sampleCounters();
+        return nestsNumber;
+    }
+
+    //Update the position of the existing nests
+    Rect innerRect = updateExistingNests(inputImage);
+    int minX = innerRect.x;
+    int minY = innerRect.y;
+    int maxX = innerRect.x + innerRect.width;
+    int maxY = innerRect.y + innerRect.height;
+
+    //Calculate the new probability of the existing regions, confirmed tracks are only scored every few frames
+    vector<unsigned long> toScore;
+    vector<Rect> regions;
+    for(unsigned long r = 0; r < nests.size(); ++r)
+    {
+        if(nests[r].state == Nest::CONFIRMED && nests[r].age - nests[r].lastScored < parameters.rescoreInterval)
+            continue;
+        toScore.push_back(r);
+        regions.push_back(nests[r].rect);
+    }
+    vector<float> probabilities = classifier.Score(regions, inputImage);
+    for(unsigned long r = 0; r < toScore.size(); ++r)
+    {
+        Nest &nest = nests[toScore[r]];
+        nest.probability = parameters.probabilityAlpha * probabilities[r] +
+                           (1 - parameters.probabilityAlpha) * nest.probability;
+        nest.lastScored = nest.age;
+    }
+
+    //The proposals left by the previous frame go before the new ones
+    scoreCarried(inputImage);
+
+    //Extract the part of the images to be processed
+    //Start taking the top part
+    int nestsNumber = (int) nests.size();
+    Mat toProcess;
+    if(minY > geometry.height)
+    {
+        toProcess = inputImage(Rect(0, 0, inputImage.cols, minY));
+        nestsNumber += classifyImage(toProcess);
+    }
+    //Bottom
+    if(inputImage.rows - maxY > geometry.height)
+    {
+        toProcess = inputImage(Rect(0, maxY, inputImage.cols, inputImage.rows - maxY - 1));
+        nestsNumber += classifyImage(toProcess, 0, maxY);
+    }
+    //Left
+    if(maxY - minY > geometry.height && minX > geometry.width)
+    {
+        toProcess = inputImage(Rect(0, minY, minX, maxY - minY));
+        nestsNumber += classifyImage(toProcess, 0, minY);
+    }
+    //Right
+    if(maxY - minY > geometry.height && inputImage.cols - maxX > geometry.width)
+    {
+        toProcess = inputImage(Rect(maxX, minY, inputImage.cols - maxX, maxY - minY));
+        nestsNumber += classifyImage(toProcess, maxX, minY);
+    }
+    unscoredFraction = proposedRegions > 0 ? (float) unscoredRegions / proposedRegions : 0;
+
+    //The current frame is the previous one of the next frame, only the handles are swapped
+    frames[current].image.release();
+    current = 1 - current;
+    Profiler::sampleCounters();
+    return nestsNumber;
+}
+
+void Tracker::Reset()
+{
+    //Neither the tracks nor the proposals left unscored are carried to another video
+    nests.clear();
+    carried.clear();
+}
+
+float Tracker::getUnscoredFraction() const
+{
+    return unscoredFraction;
+}
+
+void Tracker::prepareFrame(const cv::Mat &inputImage)
+{
+    ScopedTimer timer("prepare frame");
+    //Build the grayscale image and its pyramid once, they are shared by the feature selection and the optical flow.
+    //The buffers of the frame before the previous one are reused.
+    Frame &frame = frames[current];
+    frame.image = inputImage;
+    cvtColor(inputImage, frame.gray, CV_RGB2GRAY, 0);
+    frame.pyramidLevels = buildOpticalFlowPyramid(frame.gray, frame.pyramid,
+                                                  Size(parameters.lkWindow, parameters.lkWindow),
+                                                  parameters.pyramidLevels);
+
+    //Integral image of the sand mask, counts the sand pixels of each proposal
+    if(parameters.sandMask)
+        integral(cv::min(sandMask.compute(inputImage), 1), frame.sandSum, CV_32S);
+}
+
+void Tracker::addPrediction(Rect region, float probability, const Mat &inputImage)
+{
+    //Check list of regions if overlaps with anyone
+    Profiler::count("nms comparisons", (long long) nests.size());
+    vector<unsigned long> toDelete;
+    for(unsigned long r = 0; r < nests.size(); ++r)
+    {
+        if((nests[r].rect & region).area() <= 0)
+            continue;
+
+        //If it intersects, check the probability
+        if(probability <= nests[r].probability)
+            return;
+
+        //Delete the current element if the new probability is higher
+        toDelete.push_back(r);
+    }
+
+    //The new region keeps the identity of the oldest track it replaces
+    Nest nest(nextId, region, probability, getFeaturesToTrack(region));
+    for(vector<unsigned long>::iterator it = toDelete.begin(); it != toDelete.end(); ++it)
+    {
+        const Nest &replaced = nests[*it];
+        if(replaced.age > 0 && (nest.age == 0 || replaced.id < nest.id))
+        {
+            nest.id = replaced.id;
+            nest.state = replaced.state == Nest::COASTING ? Nest::CONFIRMED : replaced.state;
+            nest.age = replaced.age;
+            nest.hits = replaced.hits + 1;
+            nest.lastScored = replaced.age;
+        }
+    }
+    if(nest.id == nextId)
+        nextId++;
+
+    for(vector<unsigned long>::reverse_iterator it = toDelete.rbegin(); it != toDelete.rend(); ++it)
+    {
+        nests.erase(nests.begin() + *it);
+    }
+    nests.push_back(nest);
+}
+
+vector<Point2f> Tracker::getFeaturesToTrack(const Rect &region) const
+{
+    //Get the features to track from the grayscale frame
+    vector<Point2f> points;
+    goodFeaturesToTrack(frames[current].gray(region), points, parameters.featuresPerNest, parameters.featureQuality, 7,
+                        Mat(), 7);
+    for(vector<Point2f>::iterator it = points.begin(); it != points.end(); ++it)
+    {
+        it->x += region.x;
+        it->y += region.y;
+    }
+    return points;
+}
+
+int Tracker::classifyImage(const cv::Mat &input, int xOffset, int yOffset)
+{
+    ScopedTimer timer("propose");
+    //Select either slide window or selective search method
+    ISlideMethod* method;
+    if(parameters.method == ISlideMethod::SELECTIVE)
+        method = new SelectiveMethod(parameters);
+    else
+        method = new SlideWindowMethod(parameters.windowSize > 0 ? parameters.windowSize : geometry.height);
+    //Initialize slide window
+    method->initializeSlideWindow(input);
+
+    vector<Rect> regions;
+    while(true)
+    {
+        //Get a proposed region
+        Rect region = method->getProposedRegion();
+        if(region.height == 0 && region.width == 0)
+            break;
+        Profiler::count("proposals");
+
+        //Skip the regions mostly outside the sand
+        Rect frameRegion(region.x + xOffset, region.y + yOffset, region.width, region.height);
+        if(parameters.sandMask && sandPixels(frameRegion) < parameters.maskFraction * region.area())
+        {
+            Profiler::count("proposals outside mask");
+            continue;
+        }
+        regions.push_back(region);
+    }
+    method->clear();
+    delete method;
+
+    //With a deadline the regions with more contrast are scored first
+    if(parameters.frameBudget > 0)
+        Classifier::Rank(input, regions);
+    scoreRegions(input, regions, xOffset, yOffset);
+
+    //Return the number of nests
+    return (int) nests.size();
+}
+
+void Tracker::scoreRegions(const cv::Mat &input, const vector<Rect> &regions, int xOffset, int yOffset)
+{
+    //Classify them in batches, the nests are added in the order of the regions
+    proposedRegions += (int) regions.size();
+    for(unsigned long start = 0; start < regions.size(); start += parameters.batchSize)
+    {
+        //The regions left when the deadline passes are kept for the next frame, up to the maximum of regions
+        if(std::chrono::steady_clock::now() >= deadline)
+        {
+            for(unsigned long r = start; r < regions.size() && (int) carried.size() < parameters.maxRegions; ++r)
+                carried.push_back(Rect(regions[r].x + xOffset, regions[r].y + yOffset, regions[r].width,
+                                       regions[r].height));
+            Profiler::count("proposals past deadline", (long long) (regions.size() - start));
+            unscoredRegions += (int) (regions.size() - start);
+            return;
+        }
+
+        unsigned long end = std::min(regions.size(), start + parameters.batchSize);
+        vector<Rect> batch(regions.begin() + start, regions.begin() + end);
+        vector<float> probabilities = classifier.Score(batch, input);
+        for(unsigned long r = 0; r < batch.size(); ++r)
+        {
+            //Increase the region with the offset
+            Rect nestRegion = batch[r];
+            nestRegion.x += xOffset;
+            nestRegion.y += yOffset;
+
+            //If it contains a nest add it to the vector
+            addPrediction(nestRegion, probabilities[r], input);
+        }
+    }
+}
+
+void Tracker::scoreCarried(const cv::Mat &inputImage)
+{
+    //Regions of the previous frame at the same position, the ones now covered by a track are not needed any more
+    vector<Rect> regions;
+    Rect frameRect(0, 0, inputImage.cols, inputImage.rows);
+    for(vector<Rect>::iterator it = carried.begin(); it != carried.end(); ++it)
+    {
+        bool tracked = false;
+        for(vector<Nest>::iterator nest = nests.begin(); nest != nests.end() && !tracked; ++nest)
+            tracked = (nest->rect & *it).area() > 0;
+        if(!tracked && (*it & frameRect) == *it)
+            regions.push_back(*it);
+    }
+    carried.clear();
+    scoreRegions(inputImage, regions, 0, 0);
+}
+
+int Tracker::sandPixels(const cv::Rect &region) const
+{
+    const Mat &sum = frames[current].sandSum;
+    return sum.at<int>(region.y + region.height, region.x + region.width) -
+           sum.at<int>(region.y, region.x + region.width) - sum.at<int>(region.y + region.height, region.x) +
+           sum.at<int>(region.y, region.x);
+}
+
+Rect Tracker::updateExistingNests(const cv::Mat &input)
+{
+    ScopedTimer timer("optical flow");
+    //Apply tracking using the Lucas-Kanade algorithm for Optical Flow
+    vector<Point2f> points[2];
+    vector<Point2f> backPoints;
+    vector<unsigned long> owners;
+    //Prepare the features to track contained in each region
+    for(unsigned long r = 0; r < nests.size(); ++r)
+    {
+        points[0].insert(points[0].end(), nests[r].features.begin(), nests[r].features.end());
+        owners.insert(owners.end(), nests[r].features.size(), r);
+    }
+
+    std::vector<uchar> status;
+    std::vector<uchar> backStatus;
+    std::vector<float> err;
+    const Frame &previous = frames[1 - current];
+    const Frame &frame = frames[current];
+    if(!points[0].empty())
+    {
+        TermCriteria termCriteria(TermCriteria::COUNT|TermCriteria::EPS,20,0.03);
+        Size winSize(parameters.lkWindow, parameters.lkWindow);
+        //Performs the Lucas-Kanade algorithm forwards and backwards over the pyramids of both frames
+        calcOpticalFlowPyrLK(previous.pyramid, frame.pyramid, points[0], points[1], status, err, winSize,
+                             frame.pyramidLevels, termCriteria, 0, 0.001);
+        calcOpticalFlowPyrLK(frame.pyramid, previous.pyramid, points[1], backPoints, backStatus, err, winSize,
+                             frame.pyramidLevels, termCriteria, 0, 0.001);
+    }
+
+    //Keep the features whose forward-backward error is small and collect their displacement per nest
+    vector<vector<Point2f>> tracked(nests.size());
+    vector<vector<float>> dxs(nests.size());
+    vector<vector<float>> dys(nests.size());
+    vector<float> allDx;
+    vector<float> allDy;
+    for(unsigned long r = 0; r < points[0].size(); ++r)
+    {
+        if(!status[r] || !backStatus[r] || norm(backPoints[r] - points[0][r]) > parameters.fbThreshold)
+            continue;
+        float dx = points[1][r].x - points[0][r].x;
+        float dy = points[1][r].y - points[0][r].y;
+        tracked[owners[r]].push_back(points[1][r]);
+        dxs[owners[r]].push_back(dx);
+        dys[owners[r]].push_back(dy);
+        allDx.push_back(dx);
+        allDy.push_back(dy);
+    }
+
+    //Nests without reliable features are moved with the global motion of the frame
+    float globalDx = median(allDx);
+    float globalDy = median(allDy);
+    int minX = std::numeric_limits<int>::max(), minY = std::numeric_limits<int>::max(), maxX = 0, maxY = 0;
+    //Update the position of each region with the median displacement of its features
+    for(unsigned long r = 0; r < nests.size(); ++r)
+    {
+        float dx = tracked[r].empty() ? globalDx : median(dxs[r]);
+        float dy = tracked[r].empty() ? globalDy : median(dys[r]);
+        nests[r].rect = getNewRect(nests[r].rect, dx, dy, input, minX, minY, maxX, maxY);
+        updateLifecycle(nests[r], !tracked[r].empty());
+
+        //Select new features when most of them were lost
+        if((int) tracked[r].size() * 2 < parameters.featuresPerNest && nests[r].rect.area() > 0)
+            nests[r].features = getFeaturesToTrack(nests[r].rect);
+        else
+            nests[r].features = tracked[r];
+    }
+
+    for(vector<Nest>::iterator it = nests.begin(); it != nests.end();)
+    {
+        //If the borders and area is less than the minimum required by the ConvNet, the track dies
+        if(it->rect.width < parameters.minRegionWidth || it->rect.height < parameters.minRegionHeight ||
+           it->rect.width > parameters.maxRegionWidth || it->rect.height > parameters.maxRegionHeight)
+            it->state = Nest::DEAD;
+
+        if(it->state == Nest::DEAD)
+            it = nests.erase(it);
+        else
+            ++it;
+    }
+
+    return Rect(minX, minY, maxX - minX, maxY - minY);
+}
+
+void Tracker::updateLifecycle(Nest &nest, bool tracked)
+{
+    nest.age++;
+    if(tracked)
+    {
+        nest.hits++;
+        nest.misses = 0;
+        if(nest.state == Nest::COASTING || (nest.state == Nest::BORN && nest.hits >= parameters.confirmFrames))
+            nest.state = Nest::CONFIRMED;
+        return;
+    }
+
+    //A track without reliable features coasts with the motion of the frame until it is lost for too long
+    nest.misses++;
+    if(nest.misses > parameters.maxCoastFrames)
+        nest.state = Nest::DEAD;
+    else if(nest.state == Nest::CONFIRMED)
+        nest.state = Nest::COASTING;
+}
+
+float Tracker::median(vector<float> values)
+{
+    if(values.empty())
+        return 0;
+    vector<float>::iterator middle = values.begin() + values.size() / 2;
+    std::nth_element(values.begin(), middle, values.end());
+    return *middle;
+}
+
+cv::Rect Tracker::getNewRect(cv::Rect rect, float dx, float dy, const cv::Mat &inputImage, int &minX, int &minY, int &maxX, int &maxY)
+{
+    int x, y, width, height;
+    float newX = rect.x + dx;
+    float newY = rect.y + dy;
+    //Check boundaries
+    if(newX < 0)
+        newX = 0;
+    if(newX > inputImage.cols)
+        newX = inputImage.cols;
+    if(newY < 0)
+        newY = 0;
+    if(newY > inputImage.rows)
+        newY = inputImage.rows;
+    x = (int) newX;
+    y = (int) newY;
+
+    float newW = rect.x + dx + rect.width;
+    float newH = rect.y + dy + rect.height;
+    if(newW < 0)
+        newW = 0;
+    if(newW > inputImage.cols)
+        newW = inputImage.cols;
+    if(newH < 0)
+        newH = 0;
+    if(newH > inputImage.rows)
+        newH = inputImage.rows;
+
+    width = (int) (newW - x);
+    height = (int) (newH - y);
+
+    if(x < minX)
+        minX = x;
+    if(x + width > maxX)
+        maxX = x + width;
+    if(y < minY)
+        minY = y;
+    if(y + height > maxY)
+        maxY = y + height;
+
+    return Rect(x, y, width, height);
+}
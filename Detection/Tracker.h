@@ -0,0 +1,80 @@
+//
+// Created by ricardo_8990 on 8/19/15.
+//
+
+#ifndef DETECTION_TRACKER_H
+#define DETECTION_TRACKER_H
+
+#include <chrono>
+#include <opencv2/core/mat.hpp>
+#include "Classifier.h"
+#include "Parameters.h"
+#include "SandMask.h"
+
+/*
+ * Frame class, contain the data of a frame shared by the feature selection, the optical flow and the ConvNet. The
+ * input image is only referenced, the grayscale image and its pyramid are owned by the frame and their buffers are
+ * reused by the following frames.
+ */
+struct Frame
+{
+    cv::Mat image;
+    cv::Mat gray;
+    cv::Mat sandSum;
+    std::vector<cv::Mat> pyramid;
+    int pyramidLevels;
+
+    inline Frame()
+    {
+        pyramidLevels = 0;
+    }
+};
+
+/*
+ * Tracker class, it detects the nests of the first frame of a video with the Classifier and then follows them with
+ * optical flow using the Track function which receives each frame. Only the parts of the frame away from the tracked
+ * nests are searched for new ones, and the tracked nests are scored again every few frames. With a frame budget the
+ * new proposals are ranked and scored until the deadline of the frame, the rest are scored first in the next frame.
+ */
+class Tracker
+{
+public:
+    Tracker(const std::string& model, const std::string& weights, const Parameters &parameters);
+    Tracker(const Tracker &weightsSource, const Parameters &parameters);
+    int Track(const cv::Mat &inputImage);
+    void Reset();
+    float getUnscoredFraction() const;
+    std::vector<Nest> nests;
+
+private:
+    Classifier classifier;
+    SandMask sandMask;
+    cv::Size geometry;
+    Frame frames[2];
+    int current;
+    int nextId;
+    Parameters parameters;
+
+    //Deadline of the frame, proposals left for the next frame and proposals scored or left in the current one
+    std::chrono::steady_clock::time_point deadline;
+    std::vector<cv::Rect> carried;
+    int proposedRegions;
+    int unscoredRegions;
+    float unscoredFraction;
+
+private:
+    void initialize(const Parameters &parameters);
+    void addPrediction(cv::Rect region, float probability, const cv::Mat &image);
+    void prepareFrame(const cv::Mat &inputImage);
+    int classifyImage(const cv::Mat &input, int xOffset = 0, int yOffset = 0);
+    void scoreRegions(const cv::Mat &input, const std::vector<cv::Rect> &regions, int xOffset, int yOffset);
+    void scoreCarried(const cv::Mat &inputImage);
+    int sandPixels(const cv::Rect &region) const;
+    cv::Rect2i updateExistingNests(const cv::Mat &input);
+    void updateLifecycle(Nest &nest, bool tracked);
+    std::vector<cv::Point2f> getFeaturesToTrack(const cv::Rect &region) const;
+    static float median(std::vector<float> values);
+    cv::Rect getNewRect(cv::Rect rect, float dx, float dy, const cv::Mat &inputImage, int &minX, int &minY, int &maxX, int &maxY);
+};
+
+#endif //DETECTION_TRACKER_H
@@ -0,0 +1,338 @@
+//
+// Implementation of the DetectionServer class
+//
+
+#include "DetectionServer.h"
+#include "ResultsWriter.h"
+#include <sstream>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+//Largest image accepted raw, such that a wrong size does not exhaust the memory of the server
+static const unsigned long maxContent = 512ul * 1024 * 1024;
+//Longest request line, a client sending more without a new line is disconnected
+static const unsigned long maxLine = 4096;
+//Requests of a connection waiting for a worker, its reader stops reading until one of them is taken
+static const int maxQueued = 16;
+//Bytes read from the socket at once
+static const unsigned long readSize = 64 * 1024;
+
+//The signals only write to this pipe, the acceptor waits on it together with the socket and stops the server
+static int stopPipe[2] = {-1, -1};
+
+static void requestStop(int)
+{
+    char signal = 0;
+    ssize_t written = write(stopPipe[1], &signal, 1);
+    (void) written;
+}
+
+Connection::~Connection()
+{
+    close(socket);
+}
+
+DetectionServer::DetectionServer(const string &socketPath)
+{
+    this->socketPath = socketPath;
+    listener = -1;
+    stopping = false;
+}
+
+DetectionServer::~DetectionServer()
+{
+    if(acceptor.joinable())
+    {
+        stop();
+        acceptor.join();
+    }
+    closeListener();
+}
+
+bool DetectionServer::start()
+{
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if(socketPath.size() >= sizeof(address.sun_path))
+        return false;
+    strcpy(address.sun_path, socketPath.c_str());
+
+    //The socket of a previous server which was killed is replaced
+    unlink(socketPath.c_str());
+    listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(listener < 0 || bind(listener, (sockaddr *) &address, sizeof(address)) != 0 || listen(listener, 16) != 0)
+    {
+        closeListener();
+        return false;
+    }
+    if(stopPipe[0] < 0 && pipe(stopPipe) != 0)
+    {
+        closeListener();
+        return false;
+    }
+    fcntl(stopPipe[1], F_SETFL, O_NONBLOCK);
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = requestStop;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    acceptor = thread(&DetectionServer::accept, this);
+    return true;
+}
+
+void DetectionServer::stop()
+{
+    requestStop(0);
+}
+
+bool DetectionServer::next(DetectionJob &job)
+{
+    //The queued jobs are still given after the server stops, false once there are no more
+    unique_lock<mutex> lock(jobMutex);
+    jobCondition.wait(lock, [this]() { return !jobs.empty() || stopping; });
+    if(jobs.empty())
+        return false;
+    take(job);
+    return true;
+}
+
+bool DetectionServer::tryNext(DetectionJob &job)
+{
+    lock_guard<mutex> lock(jobMutex);
+    if(jobs.empty())
+        return false;
+    take(job);
+    return true;
+}
+
+void DetectionServer::take(DetectionJob &job)
+{
+    //Called with the job mutex held, the reader of the connection may be waiting for its queue to have space
+    job = jobs.front();
+    jobs.pop_front();
+    job.connection->queued--;
+    spaceCondition.notify_all();
+}
+
+void DetectionServer::reply(const DetectionJob &job, const vector<Nest> &nests, double milliseconds)
+{
+    //The whole result is sent at once, such that the lines of requests finished by different workers are not mixed
+    ostringstream text;
+    for(vector<Nest>::const_iterator it = nests.begin(); it != nests.end(); ++it)
+    {
+        text << "{\"request\":" << job.request << ",\"x\":" << it->rect.x << ",\"y\":" << it->rect.y << ",\"width\":"
+             << it->rect.width << ",\"height\":" << it->rect.height << ",\"probability\":" << it->probability << "}\n";
+    }
+    text << "{\"request\":" << job.request << ",\"done\":true,\"nests\":" << nests.size() << ",\"milliseconds\":"
+         << milliseconds << "}\n";
+    send(*job.connection, text.str());
+}
+
+void DetectionServer::fail(const DetectionJob &job, const string &error)
+{
+    ostringstream text;
+    text << "{\"request\":" << job.request << ",\"error\":\"" << ResultsWriter::escape(error, ResultsWriter::JSON_LINES)
+         << "\"}\n";
+    send(*job.connection, text.str());
+}
+
+void DetectionServer::accept()
+{
+    pollfd descriptors[2];
+    descriptors[0].fd = listener;
+    descriptors[0].events = POLLIN;
+    descriptors[1].fd = stopPipe[0];
+    descriptors[1].events = POLLIN;
+    while(true)
+    {
+        if(poll(descriptors, 2, -1) < 0)
+        {
+            if(errno == EINTR)
+                continue;
+            break;
+        }
+        if(descriptors[1].revents != 0)
+            break;
+        if(descriptors[0].revents == 0)
+            continue;
+
+        //Out of descriptors the connection stays pending, so wait before accepting it again instead of spinning
+        int client = ::accept(listener, NULL, NULL);
+        if(client < 0)
+        {
+            if(errno != EINTR && errno != EAGAIN && errno != ECONNABORTED)
+                this_thread::sleep_for(chrono::milliseconds(100));
+            continue;
+        }
+        joinReaders(false);
+        shared_ptr<Connection> connection = make_shared<Connection>(client);
+        connections.push_back(connection);
+        readers.push_back(thread(&DetectionServer::read, this, connection));
+    }
+
+    //No new connections, the connections stop reading requests but still get the results of the queued ones
+    closeListener();
+    for(vector<weak_ptr<Connection>>::iterator it = connections.begin(); it != connections.end(); ++it)
+    {
+        shared_ptr<Connection> connection = it->lock();
+        if(connection)
+            shutdown(connection->socket, SHUT_RD);
+    }
+    joinReaders(true);
+    lock_guard<mutex> lock(jobMutex);
+    stopping = true;
+    jobCondition.notify_all();
+}
+
+void DetectionServer::closeListener()
+{
+    if(listener < 0)
+        return;
+    close(listener);
+    unlink(socketPath.c_str());
+    listener = -1;
+}
+
+void DetectionServer::joinReaders(bool all)
+{
+    //A connection released by its reader and its jobs is closed, so its reader has finished
+    for(unsigned long r = 0; r < readers.size();)
+    {
+        if(!all && !connections[r].expired())
+        {
+            ++r;
+            continue;
+        }
+        readers[r].join();
+        readers.erase(readers.begin() + r);
+        connections.erase(connections.begin() + r);
+    }
+}
+
+void DetectionServer::read(shared_ptr<Connection> connection)
+{
+    //The connection stays open while its requests are queued, the jobs hold it too
+    string line;
+    int request = 0;
+    while(readLine(*connection, line))
+    {
+        DetectionJob job;
+        job.connection = connection;
+        job.request = ++request;
+        if(line.compare(0, 5, "path ") == 0)
+            job.path = line.substr(5);
+        else if(line.compare(0, 6, "image ") == 0)
+        {
+            unsigned long size = strtoul(line.c_str() + 6, NULL, 10);
+            if(size == 0 || size > maxContent)
+            {
+                fail(job, "invalid image size");
+                break;
+            }
+            if(!readBytes(*connection, job.content, size))
+                break;
+        }
+        else
+        {
+            fail(job, "unknown request");
+            continue;
+        }
+        push(job);
+    }
+    if(line.size() > maxLine)
+    {
+        DetectionJob job;
+        job.connection = connection;
+        job.request = ++request;
+        fail(job, "request line too long");
+    }
+
+    //No more requests, the results of the queued ones can still be sent
+    shutdown(connection->socket, SHUT_RD);
+}
+
+void DetectionServer::push(DetectionJob &job)
+{
+    //A client sending requests faster than they are classified waits, instead of queueing all of them in memory
+    unique_lock<mutex> lock(jobMutex);
+    spaceCondition.wait(lock, [&job]() { return job.connection->queued < maxQueued; });
+    job.connection->queued++;
+    jobs.push_back(job);
+    jobCondition.notify_one();
+}
+
+bool DetectionServer::readLine(Connection &connection, string &line)
+{
+    //The bytes after the line, which may be the content of a raw image, stay in the buffer of the connection. A line
+    //longer than the limit is left in line, truncated, and ends the requests of the connection
+    unsigned long searched = 0;
+    while(true)
+    {
+        unsigned long end = connection.received.find('\n', searched);
+        if(end != string::npos && end <= maxLine)
+        {
+            line = connection.received.substr(0, end);
+            connection.received.erase(0, end + 1);
+            return true;
+        }
+        if(connection.received.size() > maxLine)
+        {
+            line = connection.received.substr(0, maxLine + 1);
+            connection.received.clear();
+            return false;
+        }
+        searched = connection.received.size();
+        char buffer[readSize];
+        ssize_t count = recv(connection.socket, buffer, readSize, 0);
+        if(count <= 0)
+        {
+            line.clear();
+            return false;
+        }
+        connection.received.append(buffer, count);
+    }
+}
+
+bool DetectionServer::readBytes(Connection &connection, vector<uchar> &content, unsigned long size)
+{
+    //The start of the content may already be in the buffer of the connection
+    content.resize(size);
+    unsigned long received = min((unsigned long) connection.received.size(), size);
+    memcpy(content.data(), connection.received.data(), received);
+    connection.received.erase(0, received);
+    while(received < size)
+    {
+        ssize_t count = recv(connection.socket, content.data() + received, size - received, 0);
+        if(count <= 0)
+            return false;
+        received += count;
+    }
+    return true;
+}
+
+void DetectionServer::send(Connection &connection, const string &text)
+{
+    //A client which went away only loses its results
+    lock_guard<mutex> lock(connection.writeMutex);
+    unsigned long sent = 0;
+    while(sent < text.size())
+    {
+        ssize_t count = ::send(connection.socket, text.data() + sent, text.size() - sent, MSG_NOSIGNAL);
+        if(count <= 0)
+            return;
+        sent += count;
+    }
+}
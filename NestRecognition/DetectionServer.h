@@ -0,0 +1,95 @@
+//
+// Server of detection requests over a Unix socket, used to keep the model loaded between small batches of images.
+// Each client sends requests on its connection, one line each followed by the content of the image when it is sent
+// raw:
+//     path /folder/image.jpg
+//     image <bytes>\n<encoded image>
+// The requests of all the connections are queued together and taken by the workers, and the results are sent back as
+// soon as each image is classified, as JSON lines with the number of the request on its connection: one line per nest
+// and a final line with "done" and the time taken, or a line with "error". SIGINT, SIGTERM or stop close the socket,
+// the requests already queued are still answered and then next tells the workers to finish. A connection sending a
+// request line longer than 4 KB is closed, and one with 16 requests waiting for a worker is not read meanwhile.
+//
+
+#ifndef NESTRECOGNITION_DETECTIONSERVER_H
+#define NESTRECOGNITION_DETECTIONSERVER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include "Classifier.h"
+
+/*
+ * Connection of a client, closed when the client stops sending and the results of all its requests have been sent
+ */
+struct Connection
+{
+    int socket;
+    std::mutex writeMutex;
+    //Bytes received after the last request read, only used by the reader of the connection
+    std::string received;
+    //Jobs of the connection waiting for a worker, guarded by the job mutex of the server
+    int queued;
+
+    inline Connection(int socket)
+    {
+        this->socket = socket;
+        queued = 0;
+    }
+
+    ~Connection();
+};
+
+/*
+ * Detection request: the path of an image readable by the server or its encoded content
+ */
+struct DetectionJob
+{
+    std::shared_ptr<Connection> connection;
+    int request;
+    std::string path;
+    std::vector<uchar> content;
+};
+
+class DetectionServer
+{
+public:
+    DetectionServer(const std::string &socketPath);
+    ~DetectionServer();
+    bool start();
+    void stop();
+    bool next(DetectionJob &job);
+    bool tryNext(DetectionJob &job);
+    void reply(const DetectionJob &job, const std::vector<Nest> &nests, double milliseconds);
+    void fail(const DetectionJob &job, const std::string &error);
+
+private:
+    std::string socketPath;
+    int listener;
+    std::thread acceptor;
+    std::mutex jobMutex;
+    std::condition_variable jobCondition;
+    std::condition_variable spaceCondition;
+    std::deque<DetectionJob> jobs;
+    bool stopping;
+
+    //Thread reading the requests of each connection, the connections are only held to stop reading them
+    std::vector<std::thread> readers;
+    std::vector<std::weak_ptr<Connection>> connections;
+
+    void accept();
+    void closeListener();
+    void joinReaders(bool all);
+    void read(std::shared_ptr<Connection> connection);
+    void push(DetectionJob &job);
+    void take(DetectionJob &job);
+    static bool readLine(Connection &connection, std::string &line);
+    static bool readBytes(Connection &connection, std::vector<uchar> &content, unsigned long size);
+    static void send(Connection &connection, const std::string &text);
+};
+
+#endif //NESTRECOGNITION_DETECTIONSERVER_H
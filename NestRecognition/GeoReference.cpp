@@ -0,0 +1,335 @@
+//
+// Implementation of the GeoReference class
+//
+
+#include "GeoReference.h"
+#include "ResultsWriter.h"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <algorithm>
+#include <cstdint>
+
+using namespace std;
+using namespace cv;
+
+static Matx33d rotationX(double degrees)
+{
+    double angle = degrees * CV_PI / 180;
+    return Matx33d(1, 0, 0,
+                   0, cos(angle), -sin(angle),
+                   0, sin(angle), cos(angle));
+}
+
+static Matx33d rotationY(double degrees)
+{
+    double angle = degrees * CV_PI / 180;
+    return Matx33d(cos(angle), 0, sin(angle),
+                   0, 1, 0,
+                   -sin(angle), 0, cos(angle));
+}
+
+static Matx33d rotationZ(double degrees)
+{
+    double angle = degrees * CV_PI / 180;
+    return Matx33d(cos(angle), -sin(angle), 0,
+                   sin(angle), cos(angle), 0,
+                   0, 0, 1);
+}
+
+static string baseName(const string &path)
+{
+    string::size_type slash = path.find_last_of('/');
+    return slash == string::npos ? path : path.substr(slash + 1);
+}
+
+/*
+ * Fields of a CSV line, quoted as ResultsWriter writes them when they contain a comma or a quote
+ */
+static vector<string> splitFields(const string &line)
+{
+    vector<string> fields(1);
+    bool quoted = false;
+    for(string::size_type r = 0; r < line.size(); ++r)
+    {
+        char character = line[r];
+        if(quoted && character == '"' && r + 1 < line.size() && line[r + 1] == '"')
+        {
+            fields.back() += '"';
+            ++r;
+        }
+        else if(character == '"')
+            quoted = !quoted;
+        else if(character == ',' && !quoted)
+            fields.push_back(string());
+        else if(character != '\r' || quoted)
+            fields.back() += character;
+    }
+    return fields;
+}
+
+/*
+ * Numeric fields of a line separated by spaces to be read from a stream, without the field of the name
+ */
+static string numericFields(const vector<string> &fields, unsigned long name)
+{
+    string numbers;
+    for(unsigned long r = 0; r < fields.size(); ++r)
+    {
+        if(r != name)
+            numbers += fields[r] + " ";
+    }
+    return numbers;
+}
+
+GeoReference::GeoReference(double focalLength, Point2d principalPoint, double dedupRadius)
+{
+    this->focalLength = focalLength;
+    this->principalPoint = principalPoint;
+    this->dedupRadius = dedupRadius;
+    hasOrigin = false;
+    originLatitude = 0;
+    originLongitude = 0;
+}
+
+bool GeoReference::loadPoses(const string &fileName)
+{
+    ifstream file(fileName.c_str());
+    if(!file.is_open())
+    {
+        cerr << "Could not open pose file " << fileName << endl;
+        return false;
+    }
+
+    //Each line is image,latitude,longitude,altitude,yaw,pitch,roll
+    string line;
+    while(getline(file, line))
+    {
+        if(line.empty() || line[0] == '#')
+            continue;
+        vector<string> fields = splitFields(line);
+        if(fields.size() != 7)
+            continue;
+
+        istringstream stream(numericFields(fields, 0));
+        CameraPose pose;
+        if(!(stream >> pose.latitude >> pose.longitude >> pose.altitude >> pose.yaw >> pose.pitch >> pose.roll))
+            continue;
+        poses[baseName(fields[0])] = pose;
+    }
+    return true;
+}
+
+bool GeoReference::getPose(const string &image, CameraPose &pose) const
+{
+    unordered_map<string, CameraPose>::const_iterator it = poses.find(baseName(image));
+    if(it == poses.end())
+        return false;
+    pose = it->second;
+    return true;
+}
+
+double GeoReference::getGroundSampling(const CameraPose &pose) const
+{
+    //Metres per pixel at the centre of the image, the optical axis gets longer as the camera tilts
+    double distance = pose.altitude / (std::cos(pose.pitch * CV_PI / 180) * std::cos(pose.roll * CV_PI / 180));
+    return distance / focalLength;
+}
+
+bool GeoReference::project(const CameraPose &pose, Size imageSize, Point2d pixel, double &latitude,
+                           double &longitude) const
+{
+    //Ray of the pixel in camera coordinates: x right, y down, z along the optical axis
+    double cx = principalPoint.x < 0 ? imageSize.width / 2.0 : principalPoint.x;
+    double cy = principalPoint.y < 0 ? imageSize.height / 2.0 : principalPoint.y;
+    Vec3d ray((pixel.x - cx) / focalLength, (pixel.y - cy) / focalLength, 1);
+
+    //Camera looking down with the top of the image to the north, expressed in east, north, up coordinates
+    Matx33d nadir(1, 0, 0,
+                  0, -1, 0,
+                  0, 0, -1);
+    Vec3d world = rotationZ(-pose.yaw) * nadir * rotationX(pose.pitch) * rotationY(pose.roll) * ray;
+
+    //Intersect the ray with the ground plane
+    if(world[2] >= 0)
+        return false;
+    double distance = pose.altitude / -world[2];
+    double east = distance * world[0];
+    double north = distance * world[1];
+
+    latitude = pose.latitude + (north / earthRadius) * 180 / CV_PI;
+    longitude = pose.longitude + (east / (earthRadius * cos(pose.latitude * CV_PI / 180))) * 180 / CV_PI;
+    return true;
+}
+
+int GeoReference::addNests(const string &image, Size imageSize, const vector<Nest> &nests, float threshold)
+{
+    CameraPose pose;
+    if(!getPose(image, pose))
+        return 0;
+
+    int newNests = 0;
+    for(vector<Nest>::const_iterator it = nests.begin(); it != nests.end(); ++it)
+    {
+        if(it->probability < threshold)
+            continue;
+
+        //Project the centre of the box
+        Point2d centre(it->rect.x + it->rect.width / 2.0, it->rect.y + it->rect.height / 2.0);
+        double latitude, longitude;
+        if(!project(pose, imageSize, centre, latitude, longitude))
+            continue;
+
+        if(addSighting(latitude, longitude, it->probability, 1, baseName(image)))
+            newNests++;
+    }
+    return newNests;
+}
+
+int GeoReference::merge(const string &fileName)
+{
+    ifstream file(fileName.c_str());
+    if(!file.is_open())
+        return -1;
+
+    //Each line is id,latitude,longitude,probability,sightings,image as written by write
+    int newNests = 0;
+    string line;
+    getline(file, line);
+    while(getline(file, line))
+    {
+        vector<string> fields = splitFields(line);
+        if(fields.size() != 6)
+            continue;
+
+        istringstream stream(numericFields(fields, 5));
+        int id, sightings;
+        double latitude, longitude;
+        float probability;
+        if(!(stream >> id >> latitude >> longitude >> probability >> sightings))
+            continue;
+        if(addSighting(latitude, longitude, probability, sightings, fields[5]))
+            newNests++;
+    }
+    return newNests;
+}
+
+bool GeoReference::addSighting(double latitude, double longitude, float probability, int sightings,
+                               const string &image)
+{
+    if(!hasOrigin)
+    {
+        originLatitude = latitude;
+        originLongitude = longitude;
+        hasOrigin = true;
+    }
+    double east, north;
+    toLocal(latitude, longitude, east, north);
+
+    //If it was already seen keep the position of the most probable sighting
+    int nearest = findNearest(east, north);
+    if(nearest >= 0)
+    {
+        GeoNest &geoNest = geoNests[nearest];
+        geoNest.sightings += sightings;
+        if(probability > geoNest.probability)
+        {
+            removeCell(nearest);
+            geoNest.latitude = latitude;
+            geoNest.longitude = longitude;
+            geoNest.east = east;
+            geoNest.north = north;
+            geoNest.probability = probability;
+            geoNest.image = image;
+            insertCell(nearest);
+        }
+        return false;
+    }
+
+    GeoNest geoNest;
+    geoNest.id = (int) geoNests.size();
+    geoNest.latitude = latitude;
+    geoNest.longitude = longitude;
+    geoNest.east = east;
+    geoNest.north = north;
+    geoNest.probability = probability;
+    geoNest.sightings = sightings;
+    geoNest.image = image;
+    geoNests.push_back(geoNest);
+    insertCell(geoNest.id);
+    return true;
+}
+
+bool GeoReference::write(const string &fileName) const
+{
+    ofstream file(fileName.c_str());
+    if(!file.is_open())
+        return false;
+
+    file << "id,latitude,longitude,probability,sightings,image\n";
+    file << setprecision(10);
+    for(vector<GeoNest>::const_iterator it = geoNests.begin(); it != geoNests.end(); ++it)
+    {
+        file << it->id << "," << it->latitude << "," << it->longitude << "," << it->probability << ","
+             << it->sightings << "," << ResultsWriter::escape(it->image, ResultsWriter::CSV) << "\n";
+    }
+    return true;
+}
+
+void GeoReference::toLocal(double latitude, double longitude, double &east, double &north) const
+{
+    //Equirectangular approximation, accurate for the extent of a beach survey
+    north = (latitude - originLatitude) * CV_PI / 180 * earthRadius;
+    east = (longitude - originLongitude) * CV_PI / 180 * earthRadius * cos(originLatitude * CV_PI / 180);
+}
+
+long long GeoReference::cellKey(long long x, long long y) const
+{
+    //Shifted unsigned, the cells west and south of the origin are negative
+    return (long long) (((unsigned long long) x << 32) ^ (unsigned long long) (uint32_t) y);
+}
+
+int GeoReference::findNearest(double east, double north) const
+{
+    //The cells are as big as the radius, so only the neighbouring cells have to be checked
+    long long x = (long long) floor(east / dedupRadius);
+    long long y = (long long) floor(north / dedupRadius);
+    int nearest = -1;
+    double nearestDistance = dedupRadius;
+    for(long long r = x - 1; r <= x + 1; ++r)
+    {
+        for(long long s = y - 1; s <= y + 1; ++s)
+        {
+            unordered_map<long long, vector<int>>::const_iterator cell = cells.find(cellKey(r, s));
+            if(cell == cells.end())
+                continue;
+            for(vector<int>::const_iterator it = cell->second.begin(); it != cell->second.end(); ++it)
+            {
+                double distance = hypot(geoNests[*it].east - east, geoNests[*it].north - north);
+                if(distance <= nearestDistance)
+                {
+                    nearest = *it;
+                    nearestDistance = distance;
+                }
+            }
+        }
+    }
+    return nearest;
+}
+
+void GeoReference::insertCell(int index)
+{
+    long long x = (long long) floor(geoNests[index].east / dedupRadius);
+    long long y = (long long) floor(geoNests[index].north / dedupRadius);
+    cells[cellKey(x, y)].push_back(index);
+}
+
+void GeoReference::removeCell(int index)
+{
+    long long x = (long long) floor(geoNests[index].east / dedupRadius);
+    long long y = (long long) floor(geoNests[index].north / dedupRadius);
+    vector<int> &cell = cells[cellKey(x, y)];
+    cell.erase(std::remove(cell.begin(), cell.end(), index), cell.end());
+}
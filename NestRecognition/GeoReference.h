@@ -0,0 +1,81 @@
+//
+// Projection of the nests detected in an image to ground coordinates using the intrinsics of the camera and the pose
+// of the drone when the image was taken. The same nest seen in overlapping images is merged using a spatial hash over
+// a local metric grid, such that the output contains one element per physical nest.
+//
+
+#ifndef NESTRECOGNITION_GEOREFERENCE_H
+#define NESTRECOGNITION_GEOREFERENCE_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <opencv2/core.hpp>
+#include "Classifier.h"
+
+/*
+ * Pose of the camera: position in degrees, altitude above the ground in metres, heading (yaw) clockwise from north,
+ * tilt from nadir (pitch) and roll in degrees. With all angles 0 the camera looks straight down with the top of the
+ * image pointing north.
+ */
+struct CameraPose
+{
+    double latitude;
+    double longitude;
+    double altitude;
+    double yaw;
+    double pitch;
+    double roll;
+};
+
+/*
+ * Nest located on the ground, east and north are metres from the origin of the survey.
+ */
+struct GeoNest
+{
+    int id;
+    double latitude;
+    double longitude;
+    double east;
+    double north;
+    float probability;
+    int sightings;
+    std::string image;
+};
+
+class GeoReference
+{
+public:
+    GeoReference(double focalLength, cv::Point2d principalPoint, double dedupRadius);
+    bool loadPoses(const std::string &fileName);
+    bool getPose(const std::string &image, CameraPose &pose) const;
+    double getGroundSampling(const CameraPose &pose) const;
+    bool project(const CameraPose &pose, cv::Size imageSize, cv::Point2d pixel, double &latitude,
+                 double &longitude) const;
+    int addNests(const std::string &image, cv::Size imageSize, const std::vector<Nest> &nests, float threshold);
+    int merge(const std::string &fileName);
+    bool write(const std::string &fileName) const;
+
+    std::vector<GeoNest> geoNests;
+
+private:
+    double focalLength;
+    cv::Point2d principalPoint;
+    double dedupRadius;
+    std::unordered_map<std::string, CameraPose> poses;
+    std::unordered_map<long long, std::vector<int>> cells;
+    bool hasOrigin;
+    double originLatitude;
+    double originLongitude;
+
+    static constexpr double earthRadius = 6378137.0;
+
+    bool addSighting(double latitude, double longitude, float probability, int sightings, const std::string &image);
+    void toLocal(double latitude, double longitude, double &east, double &north) const;
+    long long cellKey(long long x, long long y) const;
+    int findNearest(double east, double north) const;
+    void insertCell(int index);
+    void removeCell(int index);
+};
+
+#endif //NESTRECOGNITION_GEOREFERENCE_H
@@ -0,0 +1,143 @@
+//
+// Implementation of the MosaicReader class
+//
+
+#include "MosaicReader.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <opencv2/imgproc.hpp>
+
+using namespace std;
+using namespace cv;
+
+MosaicReader::MosaicReader()
+{
+    file = -1;
+    mapping = NULL;
+    length = 0;
+    dataOffset = 0;
+    released = 0;
+}
+
+MosaicReader::~MosaicReader()
+{
+    close();
+}
+
+bool MosaicReader::open(const string &fileName)
+{
+    close();
+    file = ::open(fileName.c_str(), O_RDONLY);
+    if(file < 0)
+        return false;
+
+    struct stat status;
+    if(fstat(file, &status) != 0 || status.st_size <= 0)
+    {
+        close();
+        return false;
+    }
+    length = (size_t) status.st_size;
+    void *address = mmap(NULL, length, PROT_READ, MAP_PRIVATE, file, 0);
+    if(address == MAP_FAILED)
+    {
+        mapping = NULL;
+        close();
+        return false;
+    }
+    mapping = (unsigned char *) address;
+
+    //The tiles are read row after row
+    madvise(mapping, length, MADV_SEQUENTIAL);
+    if(!readHeader())
+    {
+        close();
+        return false;
+    }
+    released = 0;
+    return true;
+}
+
+void MosaicReader::close()
+{
+    if(mapping != NULL)
+        munmap(mapping, length);
+    if(file >= 0)
+        ::close(file);
+    mapping = NULL;
+    file = -1;
+    length = 0;
+}
+
+Size MosaicReader::getSize() const
+{
+    return size;
+}
+
+Mat MosaicReader::readTile(Rect tile) const
+{
+    //Copy the rows of the tile out of the mapping, the PPM pixels are RGB
+    tile &= Rect(0, 0, size.width, size.height);
+    Mat image(tile.height, tile.width, CV_8UC3);
+    size_t stride = (size_t) size.width * 3;
+    for(int r = 0; r < tile.height; ++r)
+    {
+        const unsigned char *row = mapping + dataOffset + (size_t) (tile.y + r) * stride + (size_t) tile.x * 3;
+        memcpy(image.ptr(r), row, (size_t) tile.width * 3);
+    }
+    cvtColor(image, image, COLOR_RGB2BGR);
+    return image;
+}
+
+void MosaicReader::release(int rows)
+{
+    //Drop the pages of the rows which are not going to be read again, whole pages only
+    if(mapping == NULL || rows <= released)
+        return;
+    size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    size_t start = released > 0 ? dataOffset + (size_t) released * size.width * 3 : 0;
+    size_t end = dataOffset + (size_t) std::min(rows, size.height) * size.width * 3;
+    start = start / page * page;
+    end = end / page * page;
+    if(end > start)
+        madvise(mapping + start, end - start, MADV_DONTNEED);
+    released = rows;
+}
+
+bool MosaicReader::readHeader()
+{
+    //P6, width, height and maximum value separated by white spaces or comments, and a single white space before the
+    //pixels
+    if(length < 2 || mapping[0] != 'P' || mapping[1] != '6')
+        return false;
+    size_t position = 2;
+    long values[3];
+    for(int r = 0; r < 3; ++r)
+    {
+        while(position < length && (isspace(mapping[position]) || mapping[position] == '#'))
+        {
+            if(mapping[position] == '#')
+            {
+                while(position < length && mapping[position] != '\n')
+                    position++;
+            }
+            else
+                position++;
+        }
+        if(position >= length || !isdigit(mapping[position]))
+            return false;
+        values[r] = 0;
+        while(position < length && isdigit(mapping[position]))
+            values[r] = values[r] * 10 + (mapping[position++] - '0');
+    }
+    if(position >= length || !isspace(mapping[position]) || values[2] != 255 || values[0] <= 0 || values[1] <= 0)
+        return false;
+    dataOffset = position + 1;
+    size = Size((int) values[0], (int) values[1]);
+    return dataOffset + (size_t) size.width * size.height * 3 <= length;
+}
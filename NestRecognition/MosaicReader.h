@@ -0,0 +1,35 @@
+//
+// Reader of orthomosaics too large to be decoded in memory. The mosaic is a binary PPM file mapped in memory, the
+// tiles are copied out of the mapping on demand, so only the pages of the rows being read are loaded, and the rows
+// already processed can be released from memory.
+//
+
+#ifndef NESTRECOGNITION_MOSAICREADER_H
+#define NESTRECOGNITION_MOSAICREADER_H
+
+#include <string>
+#include <opencv2/core.hpp>
+
+class MosaicReader
+{
+public:
+    MosaicReader();
+    ~MosaicReader();
+    bool open(const std::string &fileName);
+    void close();
+    cv::Size getSize() const;
+    cv::Mat readTile(cv::Rect tile) const;
+    void release(int rows);
+
+private:
+    int file;
+    unsigned char *mapping;
+    size_t length;
+    size_t dataOffset;
+    cv::Size size;
+    int released;
+
+    bool readHeader();
+};
+
+#endif //NESTRECOGNITION_MOSAICREADER_H
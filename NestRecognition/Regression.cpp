@@ -0,0 +1,421 @@
+//
+// Implementation of the Regression class
+//
+
+#include "Regression.h"
+#include <opencv2/imgcodecs.hpp>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <unordered_map>
+#include <iterator>
+#include <chrono>
+#include <cmath>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "SelectiveMethod.h"
+#include "SlideWindowMethod.h"
+#include "SelectiveSearchMethod/SelectiveSearchMethod.h"
+
+using namespace std;
+using namespace std::chrono;
+using namespace cv;
+
+static double milliseconds(steady_clock::time_point start, steady_clock::time_point end)
+{
+    return duration_cast<duration<double, milli>>(end - start).count();
+}
+
+static bool lessRect(const Rect &a, const Rect &b)
+{
+    if(a.x != b.x)
+        return a.x < b.x;
+    if(a.y != b.y)
+        return a.y < b.y;
+    if(a.width != b.width)
+        return a.width < b.width;
+    return a.height < b.height;
+}
+
+Regression::Regression(const string &corpus, const Parameters &parameters)
+{
+    this->corpus = corpus;
+    this->parameters = parameters;
+}
+
+string Regression::getParametersFile() const
+{
+    return corpus + "/golden/parameters.cfg";
+}
+
+int Regression::record(Classifier &classifier)
+{
+    mkdir((corpus + "/golden").c_str(), 0755);
+
+    //The parameters are kept such that the verification uses the same ones
+    ofstream parametersFile(getParametersFile().c_str());
+    if(!parametersFile.is_open())
+    {
+        cerr << "Could not write " << getParametersFile() << endl;
+        return 1;
+    }
+    parameters.print(parametersFile);
+
+    int recorded = 0;
+    vector<string> images = listImages();
+    for(vector<string>::iterator it = images.begin(); it != images.end(); ++it)
+    {
+        Mat image = imread(corpus + "/images/" + *it, 1);
+        if(!image.data)
+            continue;
+
+        GoldenImage golden = run(classifier, image);
+        if(!save(corpus + "/golden/" + *it + ".yml.gz", golden))
+        {
+            cerr << "Could not write the golden outputs of " << *it << endl;
+            return 1;
+        }
+        cout << *it << ": " << golden.proposals.size() << " proposals, " << golden.detections.size()
+             << " detections" << endl;
+        recorded++;
+    }
+    cout << "Recorded " << recorded << " images" << endl;
+    return recorded > 0 ? 0 : 1;
+}
+
+int Regression::verify(Classifier &classifier, ostream &output)
+{
+    loadAnnotations();
+
+    int failures = 0;
+    int images = 0;
+    double goldenTime[3] = {0, 0, 0};
+    double currentTime[3] = {0, 0, 0};
+    //Matches against the ground truth: true positives, detections and ground truth boxes
+    int goldenTruth[3] = {0, 0, 0};
+    int currentTruth[3] = {0, 0, 0};
+
+    output << "image,label mismatch,proposal mismatch,recall,precision,max probability delta,segmentation ms,"
+           << "golden segmentation ms,proposals ms,golden proposals ms,classify ms,golden classify ms,result\n";
+    vector<string> names = listImages();
+    for(vector<string>::iterator it = names.begin(); it != names.end(); ++it)
+    {
+        Mat image = imread(corpus + "/images/" + *it, 1);
+        if(!image.data)
+            continue;
+        images++;
+
+        GoldenImage golden;
+        if(!load(corpus + "/golden/" + *it + ".yml.gz", golden))
+        {
+            output << *it << ",,,,,,,,,,,,no golden outputs\n";
+            failures++;
+            continue;
+        }
+        GoldenImage current = run(classifier, image);
+
+        //Segmentation and proposals
+        double labels = labelMismatch(golden.labels, current.labels);
+        double proposals = proposalMismatch(golden.proposals, current.proposals);
+
+        //Detections above the threshold against the recorded ones
+        vector<Rect> goldenPositives = positives(golden.detections);
+        vector<Rect> currentPositives = positives(current.detections);
+        int matched = matchDetections(goldenPositives, currentPositives);
+        double recall = goldenPositives.empty() ? 1 : (double) matched / goldenPositives.size();
+        double precision = currentPositives.empty() ? 1 : (double) matched / currentPositives.size();
+
+        //Probability of the boxes found in both
+        double maxDelta = 0;
+        for(vector<Nest>::iterator g = golden.detections.begin(); g != golden.detections.end(); ++g)
+        {
+            for(vector<Nest>::iterator c = current.detections.begin(); c != current.detections.end(); ++c)
+            {
+                if(g->rect == c->rect)
+                    maxDelta = std::max(maxDelta, (double) fabs(g->probability - c->probability));
+            }
+        }
+
+        bool passed = labels <= parameters.labelTolerance && proposals <= parameters.proposalTolerance &&
+                      recall >= 1 - parameters.detectionTolerance && precision >= 1 - parameters.detectionTolerance &&
+                      maxDelta <= parameters.probabilityTolerance;
+        if(!passed)
+            failures++;
+
+        output << *it << "," << labels << "," << proposals << "," << recall << "," << precision << "," << maxDelta
+               << "," << current.segmentationTime << "," << golden.segmentationTime << "," << current.proposalTime
+               << "," << golden.proposalTime << "," << current.classifyTime << "," << golden.classifyTime << ","
+               << (passed ? "pass" : "FAIL") << "\n";
+
+        goldenTime[0] += golden.segmentationTime;
+        goldenTime[1] += golden.proposalTime;
+        goldenTime[2] += golden.classifyTime;
+        currentTime[0] += current.segmentationTime;
+        currentTime[1] += current.proposalTime;
+        currentTime[2] += current.classifyTime;
+
+        map<string, vector<Rect>>::iterator truth = annotations.find(*it);
+        if(truth != annotations.end())
+        {
+            goldenTruth[0] += matchDetections(truth->second, goldenPositives);
+            goldenTruth[1] += (int) goldenPositives.size();
+            goldenTruth[2] += (int) truth->second.size();
+            currentTruth[0] += matchDetections(truth->second, currentPositives);
+            currentTruth[1] += (int) currentPositives.size();
+            currentTruth[2] += (int) truth->second.size();
+        }
+    }
+
+    //Precision and recall against the ground truth can not be lower than the ones of the recording
+    if(goldenTruth[2] > 0)
+    {
+        double goldenRecall = (double) goldenTruth[0] / goldenTruth[2];
+        double currentRecall = (double) currentTruth[0] / currentTruth[2];
+        double goldenPrecision = goldenTruth[1] > 0 ? (double) goldenTruth[0] / goldenTruth[1] : 1;
+        double currentPrecision = currentTruth[1] > 0 ? (double) currentTruth[0] / currentTruth[1] : 1;
+        output << "Ground truth recall " << currentRecall << " (golden " << goldenRecall << "), precision "
+               << currentPrecision << " (golden " << goldenPrecision << ")\n";
+        if(currentRecall < goldenRecall - parameters.detectionTolerance ||
+           currentPrecision < goldenPrecision - parameters.detectionTolerance)
+        {
+            output << "Precision/recall against the ground truth regressed\n";
+            failures++;
+        }
+    }
+
+    const char *stages[3] = {"Segmentation", "Proposals", "Classify"};
+    for(int r = 0; r < 3; ++r)
+    {
+        output << stages[r] << " total " << currentTime[r] << " ms, golden " << goldenTime[r] << " ms";
+        if(currentTime[r] > 0)
+            output << ", speedup " << goldenTime[r] / currentTime[r];
+        output << "\n";
+    }
+    output << images << " images, " << failures << " failures\n";
+    return failures;
+}
+
+vector<string> Regression::listImages() const
+{
+    vector<string> images;
+    DIR* dir;
+    struct dirent *ent;
+    if((dir = opendir((corpus + "/images").c_str())) != NULL)
+    {
+        while((ent = readdir(dir)) != NULL)
+        {
+            if(ent->d_name[0] != '.')
+                images.push_back(ent->d_name);
+        }
+        closedir(dir);
+    }
+    std::sort(images.begin(), images.end());
+    return images;
+}
+
+void Regression::loadAnnotations()
+{
+    //Each line is image,x,y,width,height
+    annotations.clear();
+    ifstream file((corpus + "/annotations.csv").c_str());
+    string line;
+    while(getline(file, line))
+    {
+        if(line.empty() || line[0] == '#')
+            continue;
+        for(string::iterator it = line.begin(); it != line.end(); ++it)
+        {
+            if(*it == ',')
+                *it = ' ';
+        }
+
+        istringstream stream(line);
+        string image;
+        Rect box;
+        if(stream >> image >> box.x >> box.y >> box.width >> box.height)
+            annotations[image].push_back(box);
+    }
+}
+
+GoldenImage Regression::run(Classifier &classifier, const Mat &image) const
+{
+    GoldenImage result;
+    steady_clock::time_point t1 = steady_clock::now();
+    result.labels = ssm::SelectiveSearchMethod::segment(image, parameters.sigma, parameters.k, parameters.minSize);
+    steady_clock::time_point t2 = steady_clock::now();
+
+    //Same proposals as the classifier
+    ISlideMethod *method;
+    if(parameters.method == ISlideMethod::SELECTIVE)
+        method = new SelectiveMethod(parameters);
+    else
+        method = new SlideWindowMethod(parameters.windowSize > 0 ? parameters.windowSize :
+                                       classifier.getInputSize().height);
+    method->initializeSlideWindow(image);
+    while(true)
+    {
+        Rect region = method->getProposedRegion();
+        if(region.height == 0 && region.width == 0)
+            break;
+        result.proposals.push_back(region);
+    }
+    method->clear();
+    delete method;
+    steady_clock::time_point t3 = steady_clock::now();
+
+    //Only the scoring of the proposals found above is timed, Classify would search them again
+    classifier.Propose(image, result.proposals);
+    classifier.Collect();
+    result.detections = classifier.nests;
+    classifier.nests.clear();
+    steady_clock::time_point t4 = steady_clock::now();
+
+    result.segmentationTime = milliseconds(t1, t2);
+    result.proposalTime = milliseconds(t2, t3);
+    result.classifyTime = milliseconds(t3, t4);
+    return result;
+}
+
+bool Regression::save(const string &fileName, const GoldenImage &golden) const
+{
+    FileStorage file(fileName, FileStorage::WRITE);
+    if(!file.isOpened())
+        return false;
+
+    Mat proposals((int) golden.proposals.size(), 4, CV_32S);
+    for(int r = 0; r < proposals.rows; ++r)
+    {
+        const Rect &proposal = golden.proposals[r];
+        proposals.at<int>(r, 0) = proposal.x;
+        proposals.at<int>(r, 1) = proposal.y;
+        proposals.at<int>(r, 2) = proposal.width;
+        proposals.at<int>(r, 3) = proposal.height;
+    }
+    Mat detections((int) golden.detections.size(), 5, CV_32F);
+    for(int r = 0; r < detections.rows; ++r)
+    {
+        const Nest &nest = golden.detections[r];
+        detections.at<float>(r, 0) = nest.rect.x;
+        detections.at<float>(r, 1) = nest.rect.y;
+        detections.at<float>(r, 2) = nest.rect.width;
+        detections.at<float>(r, 3) = nest.rect.height;
+        detections.at<float>(r, 4) = nest.probability;
+    }
+
+    file << "labels" << golden.labels;
+    file << "proposals" << proposals;
+    file << "detections" << detections;
+    file << "segmentationTime" << golden.segmentationTime;
+    file << "proposalTime" << golden.proposalTime;
+    file << "classifyTime" << golden.classifyTime;
+    return true;
+}
+
+bool Regression::load(const string &fileName, GoldenImage &golden) const
+{
+    FileStorage file(fileName, FileStorage::READ);
+    if(!file.isOpened())
+        return false;
+
+    Mat proposals, detections;
+    file["labels"] >> golden.labels;
+    file["proposals"] >> proposals;
+    file["detections"] >> detections;
+    file["segmentationTime"] >> golden.segmentationTime;
+    file["proposalTime"] >> golden.proposalTime;
+    file["classifyTime"] >> golden.classifyTime;
+
+    for(int r = 0; r < proposals.rows; ++r)
+    {
+        golden.proposals.push_back(Rect(proposals.at<int>(r, 0), proposals.at<int>(r, 1), proposals.at<int>(r, 2),
+                                        proposals.at<int>(r, 3)));
+    }
+    for(int r = 0; r < detections.rows; ++r)
+    {
+        Rect rect((int) detections.at<float>(r, 0), (int) detections.at<float>(r, 1),
+                  (int) detections.at<float>(r, 2), (int) detections.at<float>(r, 3));
+        golden.detections.push_back(Nest(rect, detections.at<float>(r, 4)));
+    }
+    return true;
+}
+
+double Regression::labelMismatch(const Mat &golden, const Mat &labels)
+{
+    //The numbers given to the regions may change, so the two maps must be the same partition of the pixels: each
+    //golden label has to correspond to a single new label and the other way round
+    if(golden.size() != labels.size() || golden.type() != labels.type())
+        return 1;
+    if(golden.empty())
+        return 0;
+
+    unordered_map<int, int> forward;
+    unordered_map<int, int> backward;
+    long mismatched = 0;
+    for(int r = 0; r < golden.rows; ++r)
+    {
+        for(int s = 0; s < golden.cols; ++s)
+        {
+            int a = golden.at<int>(r, s);
+            int b = labels.at<int>(r, s);
+            unordered_map<int, int>::iterator f = forward.insert(make_pair(a, b)).first;
+            unordered_map<int, int>::iterator g = backward.insert(make_pair(b, a)).first;
+            if(f->second != b || g->second != a)
+                mismatched++;
+        }
+    }
+    return (double) mismatched / golden.total();
+}
+
+double Regression::proposalMismatch(vector<Rect> golden, vector<Rect> proposals)
+{
+    //The proposals come out of a hash table, so they are compared as sets
+    std::sort(golden.begin(), golden.end(), lessRect);
+    std::sort(proposals.begin(), proposals.end(), lessRect);
+    vector<Rect> common;
+    std::set_intersection(golden.begin(), golden.end(), proposals.begin(), proposals.end(), back_inserter(common),
+                          lessRect);
+    size_t changed = (golden.size() - common.size()) + (proposals.size() - common.size());
+    return golden.empty() ? (proposals.empty() ? 0 : 1) : (double) changed / golden.size();
+}
+
+int Regression::matchDetections(const vector<Rect> &reference, const vector<Rect> &detections) const
+{
+    //Each reference box is matched to the unmatched detection overlapping it most, with an IoU of at least 0.5
+    vector<bool> used(detections.size(), false);
+    int matched = 0;
+    for(vector<Rect>::const_iterator it = reference.begin(); it != reference.end(); ++it)
+    {
+        int best = -1;
+        double bestOverlap = 0.5;
+        for(unsigned long r = 0; r < detections.size(); ++r)
+        {
+            if(used[r])
+                continue;
+            double intersection = (*it & detections[r]).area();
+            double overlap = intersection / (it->area() + detections[r].area() - intersection);
+            if(overlap >= bestOverlap)
+            {
+                best = (int) r;
+                bestOverlap = overlap;
+            }
+        }
+        if(best >= 0)
+        {
+            used[best] = true;
+            matched++;
+        }
+    }
+    return matched;
+}
+
+vector<Rect> Regression::positives(const vector<Nest> &nests) const
+{
+    vector<Rect> boxes;
+    for(vector<Nest>::const_iterator it = nests.begin(); it != nests.end(); ++it)
+    {
+        if(it->probability >= parameters.threshold)
+            boxes.push_back(it->rect);
+    }
+    return boxes;
+}
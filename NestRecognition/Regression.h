@@ -0,0 +1,56 @@
+//
+// Golden corpus used to check that optimisations of the segmentation, the selective search or the classifier do not
+// change the detections. The corpus is a folder with the input images in corpus/images, optionally the ground truth
+// boxes in corpus/annotations.csv (image,x,y,width,height), and the recorded outputs in corpus/golden: one file per
+// image with the label map of the segmentation, the proposals and the detections, plus the parameters of the
+// recording. Verifying also times each stage against the recording, so the same corpus serves as benchmark.
+//
+
+#ifndef NESTRECOGNITION_REGRESSION_H
+#define NESTRECOGNITION_REGRESSION_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <ostream>
+#include <opencv2/core.hpp>
+#include "Classifier.h"
+
+/*
+ * Outputs of the pipeline for one image and the time taken by each stage in milliseconds
+ */
+struct GoldenImage
+{
+    cv::Mat labels;
+    std::vector<cv::Rect> proposals;
+    std::vector<Nest> detections;
+    double segmentationTime;
+    double proposalTime;
+    double classifyTime;
+};
+
+class Regression
+{
+public:
+    Regression(const std::string &corpus, const Parameters &parameters);
+    std::string getParametersFile() const;
+    int record(Classifier &classifier);
+    int verify(Classifier &classifier, std::ostream &output);
+
+private:
+    std::string corpus;
+    Parameters parameters;
+    std::map<std::string, std::vector<cv::Rect>> annotations;
+
+    std::vector<std::string> listImages() const;
+    void loadAnnotations();
+    GoldenImage run(Classifier &classifier, const cv::Mat &image) const;
+    bool save(const std::string &fileName, const GoldenImage &golden) const;
+    bool load(const std::string &fileName, GoldenImage &golden) const;
+    static double labelMismatch(const cv::Mat &golden, const cv::Mat &labels);
+    static double proposalMismatch(std::vector<cv::Rect> golden, std::vector<cv::Rect> proposals);
+    int matchDetections(const std::vector<cv::Rect> &reference, const std::vector<cv::Rect> &detections) const;
+    std::vector<cv::Rect> positives(const std::vector<Nest> &nests) const;
+};
+
+#endif //NESTRECOGNITION_REGRESSION_H
@@ -0,0 +1,136 @@
+//
+// Implementation of the ResultCache class
+//
+
+#include "ResultCache.h"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdio>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace cv;
+
+static const uint64_t fnvOffset = 14695981039346656037ULL;
+static const uint64_t fnvPrime = 1099511628211ULL;
+
+ResultCache::ResultCache(const string &directory)
+{
+    this->directory = directory;
+    mkdir(directory.c_str(), 0755);
+    mkdir((directory + "/proposals").c_str(), 0755);
+    mkdir((directory + "/nests").c_str(), 0755);
+    struct stat status;
+    open = stat((directory + "/nests").c_str(), &status) == 0 && S_ISDIR(status.st_mode);
+}
+
+bool ResultCache::isOpen() const
+{
+    return open;
+}
+
+bool ResultCache::loadProposals(const string &key, vector<Rect> &proposals) const
+{
+    //One line per proposal: x y width height
+    ifstream file((directory + "/proposals/" + key).c_str());
+    if(!file.is_open())
+        return false;
+    proposals.clear();
+    Rect region;
+    while(file >> region.x >> region.y >> region.width >> region.height)
+        proposals.push_back(region);
+    return true;
+}
+
+bool ResultCache::saveProposals(const string &key, const vector<Rect> &proposals) const
+{
+    ostringstream content;
+    for(vector<Rect>::const_iterator it = proposals.begin(); it != proposals.end(); ++it)
+        content << it->x << " " << it->y << " " << it->width << " " << it->height << "\n";
+    return save(directory + "/proposals/" + key, content.str());
+}
+
+bool ResultCache::loadNests(const string &key, vector<Nest> &nests) const
+{
+    //One line per nest: x y width height probability, the probabilities are written with all their digits
+    ifstream file((directory + "/nests/" + key).c_str());
+    if(!file.is_open())
+        return false;
+    nests.clear();
+    Rect region;
+    float probability;
+    while(file >> region.x >> region.y >> region.width >> region.height >> probability)
+        nests.push_back(Nest(region, probability));
+    return true;
+}
+
+bool ResultCache::saveNests(const string &key, const vector<Nest> &nests) const
+{
+    ostringstream content;
+    content << setprecision(9);
+    for(vector<Nest>::const_iterator it = nests.begin(); it != nests.end(); ++it)
+    {
+        content << it->rect.x << " " << it->rect.y << " " << it->rect.width << " " << it->rect.height << " "
+                << it->probability << "\n";
+    }
+    return save(directory + "/nests/" + key, content.str());
+}
+
+string ResultCache::hash(const void *data, size_t length)
+{
+    ostringstream text;
+    text << hex << setw(16) << setfill('0') << fnv1a(data, length, fnvOffset);
+    return text.str();
+}
+
+string ResultCache::hash(const string &text)
+{
+    return hash(text.data(), text.size());
+}
+
+string ResultCache::hashFile(const string &fileName)
+{
+    //Read in blocks, the weights of the network do not need to be in memory twice
+    ifstream file(fileName.c_str(), ios::binary);
+    if(!file.is_open())
+        return "";
+    vector<char> block(1 << 20);
+    uint64_t value = fnvOffset;
+    while(file)
+    {
+        file.read(block.data(), block.size());
+        value = fnv1a(block.data(), (size_t) file.gcount(), value);
+    }
+    ostringstream text;
+    text << hex << setw(16) << setfill('0') << value;
+    return text.str();
+}
+
+bool ResultCache::save(const string &fileName, const string &content) const
+{
+    //The entry only appears once it is complete
+    ostringstream temporary;
+    temporary << fileName << ".tmp" << getpid();
+    {
+        ofstream file(temporary.str().c_str());
+        if(!file.is_open())
+            return false;
+        file << content;
+        if(!file)
+            return false;
+    }
+    return rename(temporary.str().c_str(), fileName.c_str()) == 0;
+}
+
+uint64_t ResultCache::fnv1a(const void *data, size_t length, uint64_t value)
+{
+    const unsigned char *bytes = (const unsigned char *) data;
+    for(size_t r = 0; r < length; ++r)
+    {
+        value ^= bytes[r];
+        value *= fnvPrime;
+    }
+    return value;
+}
@@ -0,0 +1,39 @@
+//
+// Persistent cache of the results of a run. The entries are files named by a hash of everything the result depends on:
+// the content of the image, the parameters and the model for the nests, and the content of the image and the proposal
+// parameters for the proposals. Each entry is written to a temporary file and renamed, so an interrupted run never
+// leaves a partial entry and can be resumed from the images without one.
+//
+
+#ifndef NESTRECOGNITION_RESULTCACHE_H
+#define NESTRECOGNITION_RESULTCACHE_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <opencv2/core.hpp>
+#include "Classifier.h"
+
+class ResultCache
+{
+public:
+    ResultCache(const std::string &directory);
+    bool isOpen() const;
+    bool loadProposals(const std::string &key, std::vector<cv::Rect> &proposals) const;
+    bool saveProposals(const std::string &key, const std::vector<cv::Rect> &proposals) const;
+    bool loadNests(const std::string &key, std::vector<Nest> &nests) const;
+    bool saveNests(const std::string &key, const std::vector<Nest> &nests) const;
+
+    static std::string hash(const void *data, size_t length);
+    static std::string hash(const std::string &text);
+    static std::string hashFile(const std::string &fileName);
+
+private:
+    std::string directory;
+    bool open;
+
+    bool save(const std::string &fileName, const std::string &content) const;
+    static uint64_t fnv1a(const void *data, size_t length, uint64_t value);
+};
+
+#endif //NESTRECOGNITION_RESULTCACHE_H
@@ -0,0 +1,77 @@
+//
+// Implementation of the ResultsWriter class
+//
+
+#include "ResultsWriter.h"
+#include <sstream>
+#include <iomanip>
+
+using namespace std;
+
+ResultsWriter::ResultsWriter(const string &fileName, Format format, bool append)
+{
+    this->format = format;
+    file.open(fileName.c_str(), append ? ios::out | ios::app : ios::out | ios::trunc);
+
+    //The header of a CSV file is only written when it is created
+    file.seekp(0, ios::end);
+    if(file.is_open() && format == CSV && file.tellp() == 0)
+        file << "image,number,x,y,width,height,probability,milliseconds\n";
+}
+
+bool ResultsWriter::isOpen() const
+{
+    return file.is_open();
+}
+
+void ResultsWriter::write(const string &image, int imageNumber, const vector<Nest> &nests, double milliseconds)
+{
+    //One row per detection
+    string name = escape(image, format);
+    for(vector<Nest>::const_iterator it = nests.begin(); it != nests.end(); ++it)
+    {
+        if(format == JSON_LINES)
+        {
+            file << "{\"image\":\"" << name << "\",\"number\":" << imageNumber << ",\"x\":" << it->rect.x
+                 << ",\"y\":" << it->rect.y << ",\"width\":" << it->rect.width << ",\"height\":" << it->rect.height
+                 << ",\"probability\":" << it->probability << ",\"milliseconds\":" << milliseconds << "}\n";
+        }
+        else
+        {
+            file << name << "," << imageNumber << "," << it->rect.x << "," << it->rect.y << "," << it->rect.width
+                 << "," << it->rect.height << "," << it->probability << "," << milliseconds << "\n";
+        }
+    }
+    file.flush();
+}
+
+string ResultsWriter::escape(const string &text, Format format)
+{
+    string output;
+    if(format == CSV)
+    {
+        if(text.find_first_of(",\"\n") == string::npos)
+            return text;
+        output = "\"";
+        for(string::const_iterator it = text.begin(); it != text.end(); ++it)
+        {
+            if(*it == '"')
+                output += '"';
+            output += *it;
+        }
+        return output + "\"";
+    }
+
+    //The control characters are not allowed in a JSON string
+    ostringstream json;
+    for(string::const_iterator it = text.begin(); it != text.end(); ++it)
+    {
+        if(*it == '"' || *it == '\\')
+            json << '\\' << *it;
+        else if((unsigned char) *it < 0x20)
+            json << "\\u" << hex << setw(4) << setfill('0') << (int) (unsigned char) *it << dec;
+        else
+            json << *it;
+    }
+    return json.str();
+}
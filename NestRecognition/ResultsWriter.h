@@ -0,0 +1,29 @@
+//
+// Writer of the detections in a structured format. The file is opened in append mode and flushed after each image,
+// such that the results of an interrupted run can still be read by other tools.
+//
+
+#ifndef NESTRECOGNITION_RESULTSWRITER_H
+#define NESTRECOGNITION_RESULTSWRITER_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include "Classifier.h"
+
+class ResultsWriter
+{
+public:
+    enum Format { JSON_LINES, CSV };
+
+    ResultsWriter(const std::string &fileName, Format format, bool append = true);
+    bool isOpen() const;
+    void write(const std::string &image, int imageNumber, const std::vector<Nest> &nests, double milliseconds);
+    static std::string escape(const std::string &text, Format format);
+
+private:
+    std::ofstream file;
+    Format format;
+};
+
+#endif //NESTRECOGNITION_RESULTSWRITER_H
@@ -0,0 +1,95 @@
+//
+// Implementation of the SurveyRegistration class
+//
+
+#include "SurveyRegistration.h"
+#include <opencv2/imgproc.hpp>
+#include <opencv2/calib3d.hpp>
+
+using namespace std;
+using namespace cv;
+
+SurveyRegistration::SurveyRegistration(int memory, int features, float scale)
+    : matcher(NORM_HAMMING, true)
+{
+    this->memory = memory;
+    this->scale = scale;
+    skippedFraction = 0;
+    detector = ORB::create(features);
+}
+
+Mat SurveyRegistration::update(const Mat &image)
+{
+    //Features are extracted from a reduced grayscale image, all the geometry is computed at that scale
+    Mat small, gray;
+    resize(image, small, Size(), scale, scale, INTER_AREA);
+    cvtColor(small, gray, COLOR_BGR2GRAY);
+    vector<KeyPoint> keyPoints;
+    Mat descriptors;
+    detector->detectAndCompute(gray, noArray(), keyPoints, descriptors);
+
+    //Chain the homographies of the previous images to the current one, forget all of them if registration fails
+    Mat homography;
+    if(!previousDescriptors.empty() && registerImage(keyPoints, descriptors, homography))
+    {
+        for(deque<Mat>::iterator it = homographies.begin(); it != homographies.end(); ++it)
+            *it = homography * (*it);
+        homographies.push_front(homography);
+        if((int) homographies.size() > memory)
+            homographies.pop_back();
+    }
+    else
+        homographies.clear();
+
+    //Draw the footprints of the previous images, the rest is the ground to search
+    Mat covered = Mat::zeros(gray.size(), CV_8UC1);
+    vector<Point2f> corners;
+    corners.push_back(Point2f(0, 0));
+    corners.push_back(Point2f(previousSize.width, 0));
+    corners.push_back(Point2f(previousSize.width, previousSize.height));
+    corners.push_back(Point2f(0, previousSize.height));
+    for(deque<Mat>::iterator it = homographies.begin(); it != homographies.end(); ++it)
+    {
+        vector<Point2f> projected;
+        perspectiveTransform(corners, projected, *it);
+        vector<Point> polygon(projected.begin(), projected.end());
+        fillConvexPoly(covered, polygon, Scalar(255));
+    }
+    skippedFraction = (float) countNonZero(covered) / covered.total();
+
+    previousSize = gray.size();
+    previousKeyPoints = keyPoints;
+    previousDescriptors = descriptors;
+
+    Mat mask;
+    resize(255 - covered, mask, image.size(), 0, 0, INTER_NEAREST);
+    return mask;
+}
+
+float SurveyRegistration::getSkippedFraction() const
+{
+    return skippedFraction;
+}
+
+bool SurveyRegistration::registerImage(const vector<KeyPoint> &keyPoints, const Mat &descriptors, Mat &homography)
+{
+    if(descriptors.empty())
+        return false;
+
+    vector<DMatch> matches;
+    matcher.match(previousDescriptors, descriptors, matches);
+
+    vector<Point2f> source, destination;
+    for(vector<DMatch>::iterator it = matches.begin(); it != matches.end(); ++it)
+    {
+        source.push_back(previousKeyPoints[it->queryIdx].pt);
+        destination.push_back(keyPoints[it->trainIdx].pt);
+    }
+    if(source.size() < 10)
+        return false;
+
+    //Homography from the previous image to the current one, it is rejected if few matches agree with it
+    Mat inliers;
+    homography = findHomography(source, destination, RANSAC, 3, inliers);
+    return !homography.empty() && countNonZero(inliers) >= 10;
+}
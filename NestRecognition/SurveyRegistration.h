@@ -0,0 +1,36 @@
+//
+// Registration of consecutive survey images. Each image is registered with the previous one by matching ORB features
+// and estimating a homography, the homographies are chained to project the footprints of the last images into the
+// current one, such that only the ground which has not been covered yet needs to be searched for nests.
+//
+
+#ifndef NESTRECOGNITION_SURVEYREGISTRATION_H
+#define NESTRECOGNITION_SURVEYREGISTRATION_H
+
+#include <deque>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/features2d.hpp>
+
+class SurveyRegistration
+{
+public:
+    SurveyRegistration(int memory, int features, float scale);
+    cv::Mat update(const cv::Mat &image);
+    float getSkippedFraction() const;
+
+private:
+    int memory;
+    float scale;
+    float skippedFraction;
+    cv::Ptr<cv::ORB> detector;
+    cv::BFMatcher matcher;
+    cv::Size previousSize;
+    std::vector<cv::KeyPoint> previousKeyPoints;
+    cv::Mat previousDescriptors;
+    std::deque<cv::Mat> homographies;
+
+    bool registerImage(const std::vector<cv::KeyPoint> &keyPoints, const cv::Mat &descriptors, cv::Mat &homography);
+};
+
+#endif //NESTRECOGNITION_SURVEYREGISTRATION_H
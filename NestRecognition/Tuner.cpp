@@ -0,0 +1,192 @@
+//
+// Implementation of the Tuner class
+//
+
+#include "Tuner.h"
+#include <opencv2/imgcodecs.hpp>
+#include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "TaskPool.h"
+
+using namespace std;
+using namespace std::chrono;
+using namespace cv;
+
+//Batch sizes tried, larger batches than the proposals of an image only add padding
+static const int batchSizes[] = { 1, 2, 4, 8, 16, 32, 64 };
+
+Tuner::Tuner(const string &folder, const Parameters &parameters)
+{
+    this->folder = folder;
+    this->parameters = parameters;
+    loadImages();
+}
+
+int Tuner::run(const string &model, const string &weights, ostream &output)
+{
+    if(images.empty())
+    {
+        output << "No images to tune in " << folder << endl;
+        return 1;
+    }
+
+    //The first image allocates the buffers of the network, so it is not measured
+    Classifier classifier(model, weights, parameters);
+    classifier.Classify(images[0]);
+
+    output << images.size() << " images, " << thread::hardware_concurrency() << " cores" << endl;
+    output << "batchSize,workers,pipeline,poolThreads,images per second" << endl;
+    Parameters best = parameters;
+    double bestSpeed = 0;
+    vector<int> workers = workerCounts();
+    for(unsigned long b = 0; b < sizeof(batchSizes) / sizeof(batchSizes[0]); ++b)
+    {
+        for(vector<int>::iterator it = workers.begin(); it != workers.end(); ++it)
+        {
+            Parameters candidate = parameters;
+            candidate.batchSize = batchSizes[b];
+            candidate.workers = *it;
+            candidate.pipeline = true;
+            double speed = measure(classifier, candidate);
+            output << candidate.batchSize << "," << candidate.workers << ",1," << candidate.poolThreads << ","
+                   << speed << endl;
+            if(speed > bestSpeed)
+            {
+                best = candidate;
+                bestSpeed = speed;
+            }
+        }
+    }
+
+    //Without the pipeline the scoring runs on the thread of each worker, which can be faster when every core is busy
+    Parameters candidate = best;
+    candidate.pipeline = false;
+    double speed = measure(classifier, candidate);
+    output << candidate.batchSize << "," << candidate.workers << ",0," << candidate.poolThreads << "," << speed << endl;
+    if(speed > bestSpeed)
+    {
+        best = candidate;
+        bestSpeed = speed;
+    }
+
+    //Threads of the pool shared by the parallel loops of the workers
+    for(vector<int>::iterator it = workers.begin(); it != workers.end(); ++it)
+    {
+        candidate = best;
+        candidate.poolThreads = *it;
+        TaskPool::configure(candidate.poolThreads);
+        speed = measure(classifier, candidate);
+        output << candidate.batchSize << "," << candidate.workers << "," << candidate.pipeline << ","
+               << candidate.poolThreads << "," << speed << endl;
+        if(speed > bestSpeed)
+        {
+            best = candidate;
+            bestSpeed = speed;
+        }
+    }
+    TaskPool::configure(best.poolThreads);
+
+    if(!write(best, bestSpeed))
+    {
+        output << "Could not write the tuned configuration " << parameters.tuned << endl;
+        return 1;
+    }
+    output << "batchSize = " << best.batchSize << ", workers = " << best.workers << ", pipeline = " << best.pipeline
+           << ", poolThreads = " << best.poolThreads << " written to " << parameters.tuned << endl;
+    return 0;
+}
+
+void Tuner::loadImages()
+{
+    vector<string> names;
+    DIR* dir;
+    struct dirent *ent;
+    if((dir = opendir(folder.c_str())) != NULL)
+    {
+        while((ent = readdir(dir)) != NULL)
+        {
+            if(ent->d_name[0] != '.')
+                names.push_back(ent->d_name);
+        }
+        closedir(dir);
+    }
+    std::sort(names.begin(), names.end());
+    for(vector<string>::iterator it = names.begin(); it != names.end(); ++it)
+    {
+        Mat image = imread(folder + "/" + *it, IMREAD_COLOR);
+        if(image.data)
+            images.push_back(image);
+    }
+}
+
+double Tuner::measure(const Classifier &source, const Parameters &candidate) const
+{
+    //The classifiers of the workers share the weights, they are created before the measure
+    vector<Classifier *> classifiers;
+    for(int r = 0; r < candidate.workers; ++r)
+        classifiers.push_back(new Classifier(source, candidate));
+
+    //Each worker generates the proposals of its next image while the previous one is scored, as in a run
+    atomic<unsigned long> nextImage(0);
+    steady_clock::time_point start = steady_clock::now();
+    vector<thread> threads;
+    for(int r = 0; r < candidate.workers; ++r)
+    {
+        threads.push_back(thread([&, r]()
+        {
+            Classifier &classifier = *classifiers[r];
+            bool hasPrevious = false;
+            for(unsigned long index = nextImage++; index < images.size(); index = nextImage++)
+            {
+                classifier.Propose(images[index]);
+                if(hasPrevious)
+                    classifier.Collect();
+                hasPrevious = true;
+            }
+            if(hasPrevious)
+                classifier.Collect();
+        }));
+    }
+    for(vector<thread>::iterator it = threads.begin(); it != threads.end(); ++it)
+        it->join();
+    double seconds = duration_cast<duration<double>>(steady_clock::now() - start).count();
+
+    for(vector<Classifier *>::iterator it = classifiers.begin(); it != classifiers.end(); ++it)
+        delete *it;
+    return seconds > 0 ? images.size() / seconds : 0;
+}
+
+bool Tuner::write(const Parameters &best, double imagesPerSecond) const
+{
+    //The folder of the default file is created with the file
+    string::size_type slash = parameters.tuned.rfind('/');
+    if(slash != string::npos && slash > 0)
+        mkdir(parameters.tuned.substr(0, slash).c_str(), 0755);
+
+    ofstream file(parameters.tuned.c_str());
+    if(!file.is_open())
+        return false;
+    file << "# Written by NestRecognition --tune=" << folder << ", " << images.size() << " images at "
+         << imagesPerSecond << " images per second on " << thread::hardware_concurrency() << " cores\n";
+    file << "batchSize = " << best.batchSize << "\n";
+    file << "workers = " << best.workers << "\n";
+    file << "pipeline = " << best.pipeline << "\n";
+    file << "poolThreads = " << best.poolThreads << "\n";
+    return (bool) file;
+}
+
+vector<int> Tuner::workerCounts()
+{
+    //Powers of two up to the number of cores, and the number of cores
+    vector<int> counts;
+    int cores = std::max(1, (int) thread::hardware_concurrency());
+    for(int count = 1; count < cores; count *= 2)
+        counts.push_back(count);
+    counts.push_back(cores);
+    return counts;
+}
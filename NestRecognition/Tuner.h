@@ -0,0 +1,34 @@
+//
+// Calibration of the host. The sample images of a folder are classified with a grid of batch sizes and numbers of
+// workers, the fastest pair is measured again without the pipeline and with several sizes of the task pool, and the
+// best configuration is written as a configuration file which NestRecognition and Tracking load before their own
+// configuration and options.
+//
+
+#ifndef NESTRECOGNITION_TUNER_H
+#define NESTRECOGNITION_TUNER_H
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <opencv2/core.hpp>
+#include "Classifier.h"
+
+class Tuner
+{
+public:
+    Tuner(const std::string &folder, const Parameters &parameters);
+    int run(const std::string &model, const std::string &weights, std::ostream &output);
+
+private:
+    std::string folder;
+    Parameters parameters;
+    std::vector<cv::Mat> images;
+
+    void loadImages();
+    double measure(const Classifier &source, const Parameters &candidate) const;
+    bool write(const Parameters &best, double imagesPerSecond) const;
+    static std::vector<int> workerCounts();
+};
+
+#endif //NESTRECOGNITION_TUNER_H
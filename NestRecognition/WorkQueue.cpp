@@ -0,0 +1,209 @@
+//
+// Implementation of the WorkQueue class
+//
+
+#include "WorkQueue.h"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <utime.h>
+#include <unistd.h>
+
+using namespace std;
+
+WorkQueue::WorkQueue(const string &directory, int claimTimeout)
+{
+    this->directory = directory;
+    this->claimTimeout = claimTimeout;
+    batches = 0;
+}
+
+bool WorkQueue::initialize(const vector<string> &images, int batchSize)
+{
+    mkdir(directory.c_str(), 0755);
+    string marker = directory + "/batches";
+    string lock = directory + "/initializing";
+
+    //Wait for the process writing the batches, which renews the lock folder after each batch
+    while(true)
+    {
+        ifstream file(marker.c_str());
+        if(file >> batches)
+            return true;
+
+        //Only the process creating the lock folder writes the batches, the marker is the last thing written. A process
+        //failing to write them removes the lock, such that one of the others writes them again
+        if(mkdir(lock.c_str(), 0755) == 0)
+        {
+            bool written = writeBatches(images, batchSize);
+            rmdir(lock.c_str());
+            if(!written)
+                return false;
+            continue;
+        }
+
+        //The process holding the lock died without removing it, the queue has to be removed by hand
+        struct stat status;
+        if(stat(lock.c_str(), &status) == 0 && serverTime() - status.st_mtime >= claimTimeout)
+            return false;
+        this_thread::sleep_for(chrono::seconds(1));
+    }
+}
+
+bool WorkQueue::writeBatches(const vector<string> &images, int batchSize)
+{
+    //The batches of a process which failed before are written again
+    string building = directory + "/building";
+    mkdir(building.c_str(), 0755);
+    vector<string> stale = listFolder(building);
+    for(vector<string>::iterator it = stale.begin(); it != stale.end(); ++it)
+        remove((building + "/" + *it).c_str());
+    mkdir((directory + "/claimed").c_str(), 0755);
+    mkdir((directory + "/done").c_str(), 0755);
+
+    int count = 0;
+    for(unsigned long r = 0; r < images.size(); r += batchSize)
+    {
+        ostringstream content;
+        content << r + 1 << "\n";
+        for(unsigned long s = r; s < images.size() && s < r + batchSize; ++s)
+            content << images[s] << "\n";
+        ostringstream name;
+        name << building << "/batch" << setw(8) << setfill('0') << count++;
+        if(!writeFile(name.str(), content.str()))
+            return false;
+        utime((directory + "/initializing").c_str(), NULL);
+    }
+    ostringstream total;
+    total << count << "\n";
+    return rename(building.c_str(), (directory + "/pending").c_str()) == 0 &&
+           writeFile(directory + "/batches", total.str());
+}
+
+bool WorkQueue::claim(const string &owner, string &claimed, vector<string> &images, int &first)
+{
+    //Batches nobody claimed yet, then the ones of the workers which stopped renewing their claims
+    return claimFrom(directory + "/pending", false, owner, claimed, images, first) ||
+           claimFrom(directory + "/claimed", true, owner, claimed, images, first);
+}
+
+void WorkQueue::renew(const string &claimed)
+{
+    utime((directory + "/claimed/" + claimed).c_str(), NULL);
+}
+
+bool WorkQueue::complete(const string &claimed)
+{
+    //The name of the batch is the part before the owner, the rename fails when the claim was taken by another worker
+    string batch = claimed.substr(0, claimed.find('@'));
+    return rename((directory + "/claimed/" + claimed).c_str(), (directory + "/done/" + batch).c_str()) == 0;
+}
+
+bool WorkQueue::isFinished() const
+{
+    return (int) listFolder(directory + "/done").size() >= batches;
+}
+
+bool WorkQueue::lockMerge()
+{
+    return mkdir((directory + "/merging").c_str(), 0755) == 0;
+}
+
+void WorkQueue::unlockMerge()
+{
+    rmdir((directory + "/merging").c_str());
+}
+
+bool WorkQueue::claimFrom(const string &folder, bool onlyExpired, const string &owner, string &claimed,
+                          vector<string> &images, int &first)
+{
+    vector<string> names = listFolder(folder);
+    time_t now = onlyExpired && !names.empty() ? serverTime() : 0;
+
+    //Workers start at different batches, such that they do not all race for the same file
+    unsigned long start = names.empty() ? 0 : hash<string>()(owner) % names.size();
+    for(unsigned long r = 0; r < names.size(); ++r)
+    {
+        const string &name = names[(start + r) % names.size()];
+        string path = folder + "/" + name;
+        if(onlyExpired)
+        {
+            struct stat status;
+            if(stat(path.c_str(), &status) != 0 || now - status.st_mtime < claimTimeout)
+                continue;
+        }
+
+        //The rename only succeeds for one of the workers
+        string batch = name.substr(0, name.find('@'));
+        string target = batch + "@" + owner;
+        if(rename(path.c_str(), (directory + "/claimed/" + target).c_str()) != 0)
+            continue;
+        claimed = target;
+        renew(claimed);
+
+        images.clear();
+        ifstream file((directory + "/claimed/" + target).c_str());
+        file >> first;
+        string line;
+        while(getline(file, line))
+        {
+            if(!line.empty())
+                images.push_back(line);
+        }
+        return true;
+    }
+    return false;
+}
+
+time_t WorkQueue::serverTime() const
+{
+    //The claims are renewed with the clock of the filesystem holding the folder, which is read by touching a file of
+    //it, so the clocks of the machines sharing the queue do not need to agree
+    string clock = directory + "/clock";
+    ofstream(clock.c_str(), ios::app);
+    struct stat status;
+    if(utime(clock.c_str(), NULL) != 0 || stat(clock.c_str(), &status) != 0)
+        return time(NULL);
+    return status.st_mtime;
+}
+
+vector<string> WorkQueue::listFolder(const string &folder)
+{
+    vector<string> names;
+    DIR* dir;
+    struct dirent *ent;
+    if((dir = opendir(folder.c_str())) != NULL)
+    {
+        while((ent = readdir(dir)) != NULL)
+        {
+            if(ent->d_name[0] != '.')
+                names.push_back(ent->d_name);
+        }
+        closedir(dir);
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+bool WorkQueue::writeFile(const string &fileName, const string &content)
+{
+    //Written under another name and renamed, the other workers never read a partial file
+    string temporary = fileName + ".tmp";
+    {
+        ofstream file(temporary.c_str());
+        if(!file.is_open())
+            return false;
+        file << content;
+        if(!file)
+            return false;
+    }
+    return rename(temporary.c_str(), fileName.c_str()) == 0;
+}
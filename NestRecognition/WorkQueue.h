@@ -0,0 +1,43 @@
+//
+// Work queue shared by several processes through a folder, which can be on a filesystem shared by several machines.
+// The images are split in batches, one file each in pending/. A worker claims a batch by renaming its file into
+// claimed/, which only succeeds for one of the workers trying, and renames it into done/ when the batch is finished.
+// The first process creating the queue writes the batches, the others wait for it, so no central service is needed.
+// Claims are renewed while the batch is being processed, and the ones of a worker which died are claimed again.
+// The age of a claim is measured with the clock of the filesystem holding the folder, not the one of the worker.
+// Each batch file starts with the position in the list of its first image, followed by one image per line.
+//
+
+#ifndef NESTRECOGNITION_WORKQUEUE_H
+#define NESTRECOGNITION_WORKQUEUE_H
+
+#include <string>
+#include <vector>
+#include <ctime>
+
+class WorkQueue
+{
+public:
+    WorkQueue(const std::string &directory, int claimTimeout);
+    bool initialize(const std::vector<std::string> &images, int batchSize);
+    bool claim(const std::string &owner, std::string &claimed, std::vector<std::string> &images, int &first);
+    void renew(const std::string &claimed);
+    bool complete(const std::string &claimed);
+    bool isFinished() const;
+    bool lockMerge();
+    void unlockMerge();
+
+private:
+    std::string directory;
+    int claimTimeout;
+    int batches;
+
+    bool writeBatches(const std::vector<std::string> &images, int batchSize);
+    time_t serverTime() const;
+    bool claimFrom(const std::string &folder, bool onlyExpired, const std::string &owner, std::string &claimed,
+                   std::vector<std::string> &images, int &first);
+    static std::vector<std::string> listFolder(const std::string &folder);
+    static bool writeFile(const std::string &fileName, const std::string &content);
+};
+
+#endif //NESTRECOGNITION_WORKQUEUE_H
@@ -12,19 +12,86 @@
  */
 
 #include <iostream>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <deque>
+#include <atomic>
 #include <opencv2/core.hpp>
 #include <caffe/caffe.hpp>
 #include <opencv2/imgcodecs.hpp>
 #include <opencv2/imgproc.hpp>
 #include <chrono>
 #include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cmath>
 #include "Classifier.h"
+#include "ResultsWriter.h"
+#include "GeoReference.h"
+#include "Regression.h"
+#include "SandMask.h"
+#include "MosaicReader.h"
+#include "ResultCache.h"
+#include "SurveyRegistration.h"
+#include "WorkQueue.h"
+#include "DetectionServer.h"
+#include "Tuner.h"
+#include "Profiler.h"
+#include "TaskPool.h"
 
 using namespace std;
 using namespace std::chrono;
 using namespace cv;
 using namespace caffe;
 
+/*
+ * State of a run shared by the workers classifying the images of the folder
+ */
+struct Run
+{
+    Parameters parameters;
+    string imageDir;
+    string results;
+    vector<string> imageNames;
+    atomic<unsigned long> nextImage;
+    atomic<int> imageNumber;
+
+    mutex outputMutex;
+    ofstream log;
+    ResultsWriter *writer;
+    GeoReference *geoReference;
+    SurveyRegistration *registration;
+    ResultCache *cache;
+    WorkQueue *queue;
+    string worker;
+    string resultsExtension;
+    string proposalFingerprint;
+    string nestFingerprint;
+    int totalPositives;
+    int totalNegatives;
+    int totalTime;
+    double totalSkipped;
+};
+
+/*
+ * Comparison of the inference backend against FP32 over held-out crops
+ */
+struct Evaluation
+{
+    int samples;
+    int referenceCorrect;
+    int candidateCorrect;
+    int changedDecisions;
+    double totalDelta;
+    double maxDelta;
+    double referenceTime;
+    double candidateTime;
+};
+
 static void help()
 {
     cout
@@ -41,100 +108,1316 @@ static void help()
     << "This program detects nests within a video stream."                              << endl
     << "It requires the prototxt file and the weights to initialize the caffe "         << endl
     << "architecture. The imageFolder contaning the images to recognise and "           << endl
-    << "the Results folder name where the images are going to be stored."
+    << "the Results folder name where the images are going to be stored."             << endl
+    << "Detection parameters can be loaded from a file with --config=file and "         << endl
+    << "overridden with --name=value, e.g. --sigma=0.8 --method=window"                 << endl
+    << "The detections are written in Results/detections.jsonl (--resultsFormat=csv "  << endl
+    << "or none) and the annotated images can be disabled with --annotate=0"           << endl
+    << "With --poseFile=poses.csv --focalLength=pixels the nests are projected to the " << endl
+    << "ground and written once per physical nest in Results/nests_geo.csv"            << endl
+    << "With --survey=1 consecutive images are registered and only the ground not "     << endl
+    << "covered by the previous images is searched"                                    << endl
+    << "--workers=N classifies N images at the same time, the workers share the "      << endl
+    << "weights of the network"                                                        << endl
+    << "--backend=int8 --calibrationDir=crops runs the network quantized to 8 bits, "  << endl
+    << "--evaluatePositive=dir --evaluateNegative=dir reports its accuracy against "   << endl
+    << "FP32 over held-out crops (only the prototxt and the weights are required)"     << endl
+    << "--backend=opencv uses the dnn module of OpenCV, --benchmark=dir compares the " << endl
+    << "speed of the engines over the crops of a folder"                                << endl
+    << "--profile=trace.json records the time of each stage, see chrome://tracing"      << endl
+    << "--proposalScale=0.25 generates the proposals on a reduced copy of the image, "  << endl
+    << "--decodeReduced=1 decodes that copy directly at 1/2, 1/4 or 1/8"               << endl
+    << "--targetGsd=0.02 rescales each image to 2 cm per pixel with the altitude of "  << endl
+    << "its pose, --minNestSize --maxNestSize bound the proposals in metres"           << endl
+    << "--sandMask=1 skips the proposals outside the sand (HSV thresholds sandHue...)" << endl
+    << "--frameBudget=500 stops scoring the proposals of an image after 500 ms, the "  << endl
+    << "most contrasted first"                                                         << endl
+    << "--tileSize=4096 classifies the binary PPM mosaics of the folder in tiles"      << endl
+    << "--cacheDir=dir keeps the proposals and nests of each image, a run restarted "  << endl
+    << "or with a new model reuses them"                                               << endl
+    << "--queueDir=dir shares the images with the processes using the same queue, "   << endl
+    << "each claims --queueBatch images at a time and the last merges the results"     << endl
+    << "--serve=socket keeps the model loaded and classifies the images sent over "    << endl
+    << "that Unix socket as \"path file\" or \"image size\" lines (prototxt and "      << endl
+    << "weights only), the nests are sent back as JSON lines"                          << endl
+    << "--tune=dir times the images of dir with several batch sizes and workers and "  << endl
+    << "writes the fastest to ~/.alagba/tuned.cfg (--tuned=file), loaded by default"   << endl
+    << "--poolThreads=N runs the segmentation and preprocessing loops on N threads"   << endl
+    << "--regression=record|verify --corpus=dir stores the outputs of the images of "   << endl
+    << "dir/images and checks later builds against them (prototxt and weights only)"   << endl
     << "Usage:"                                                                         << endl
-    << "./NestRecognition deploy.prototxt weights.caffemodel ImageFolder Results"       << endl
+    << "./NestRecognition [options] deploy.prototxt weights.caffemodel ImageFolder Results" << endl
     << "------------------------------------------------------------------------------" << endl
     << endl;
 }
 
+/*
+ * Batch of images claimed from the work queue by a worker, its detections are written to their own file, which is
+ * renamed into the shards folder once the batch is finished
+ */
+struct Batch
+{
+    string claimed;
+    vector<string> images;
+    int first;
+    unsigned long next;
+    string owner;
+    string shardFile;
+    ResultsWriter *writer;
+};
+
+/*
+ * Image whose proposals have been sent to the classifier and whose nests have not been collected yet
+ */
+struct PendingImage
+{
+    string imageName;
+    Mat image;
+    int number;
+    ResultsWriter *writer;
+    double skipped;
+    double scale;
+    float sandFraction;
+    float prunedFraction;
+    bool cached;
+    string nestKey;
+    vector<Nest> nests;
+    high_resolution_clock::time_point start;
+};
+
+/*
+ * Keys of the proposals and the nests of an image in the cache. The nests depend on the image, its scale, the mask of
+ * the survey, the parameters and the model.
+ */
+static void cacheKeys(const Run &run, const vector<uchar> &bytes, double scale, const Mat &mask, string &proposalKey,
+                      string &nestKey)
+{
+    ostringstream key;
+    key << ResultCache::hash(bytes.data(), bytes.size()) << " " << scale << " ";
+    if(!mask.empty())
+        key << ResultCache::hash(mask.data, mask.total());
+    proposalKey = ResultCache::hash(key.str() + run.proposalFingerprint);
+    nestKey = ResultCache::hash(key.str() + run.proposalFingerprint + run.nestFingerprint);
+}
+
+/*
+ * Takes the nests of an image from the classifier, annotates it and writes the results. The images taken from the
+ * cache are not annotated again, the annotated copy of the run which classified them is kept.
+ */
+static void finishImage(Classifier &classifier, Run &run, PendingImage &pending)
+{
+    const Parameters &parameters = run.parameters;
+    int i = pending.number;
+    Mat &image = pending.image;
+    ostringstream newFile;
+    newFile << "Image " << i << "\n";
+    if(run.registration != NULL)
+        newFile << "Skipped pixels " << pending.skipped << "\n";
+    if(parameters.sandMask)
+        newFile << "Sand pixels " << pending.sandFraction << "\n";
+    if(run.registration != NULL || parameters.sandMask)
+        newFile << "Proposals outside the mask " << pending.prunedFraction << "\n";
+
+    //Classify, the nests of the images in the cache were not sent to the classifier
+    bool complete = true;
+    if(pending.cached)
+    {
+        newFile << "Nests taken from the cache\n";
+        classifier.nests.swap(pending.nests);
+    }
+    else
+    {
+        ScopedTimer timer("collect");
+        classifier.Collect();
+        if(parameters.frameBudget > 0)
+            newFile << "Proposals past the deadline " << classifier.getUnscoredFraction() << "\n";
+        complete = classifier.getUnscoredFraction() == 0;
+    }
+
+    //The nests were found in the image rescaled to the target ground resolution, back to the original pixels
+    if(pending.scale != 1 && !pending.cached)
+    {
+        for(vector<Nest>::iterator it = classifier.nests.begin(); it != classifier.nests.end(); ++it)
+        {
+            int x = (int) floor(it->rect.x / pending.scale);
+            int y = (int) floor(it->rect.y / pending.scale);
+            int right = (int) ceil((it->rect.x + it->rect.width) / pending.scale);
+            int bottom = (int) ceil((it->rect.y + it->rect.height) / pending.scale);
+            it->rect = Rect(x, y, right - x, bottom - y) & Rect(0, 0, image.cols, image.rows);
+        }
+    }
+    //The nests of an image cut short by the deadline would miss nests in a later run without budget
+    if(run.cache != NULL && !pending.cached && complete)
+        run.cache->saveNests(pending.nestKey, classifier.nests);
+    high_resolution_clock::time_point t2 = high_resolution_clock::now();
+
+    auto duration = std::chrono::duration_cast<std::chrono::minutes>(t2 - pending.start).count();
+    newFile << "Time taken: " << duration << " \n";
+
+    //Count the nests and add rectangles to the image
+    int negatives = 0;
+    int positives = 0;
+    for(vector<Nest>::iterator it = classifier.nests.begin(); it != classifier.nests.end(); ++it)
+    {
+        Scalar colour;
+        if(it->probability >= parameters.threshold)
+        {
+            colour = Scalar(0, 255, 0);
+            positives++;
+        }
+        else
+        {
+            colour = Scalar(255, 0, 0);
+            negatives++;
+        }
+        if(parameters.annotate && !pending.cached)
+        {
+            rectangle(image, it->rect, colour, 2, LINE_AA, 0);
+            putText(image, to_string(it->probability), it->rect.br(), FONT_HERSHEY_COMPLEX, 1, colour, 2,
+                    LINE_AA, 0);
+        }
+    }
+    if(parameters.annotate && !pending.cached)
+    {
+        ScopedTimer timer("write image");
+        String name = run.imageDir + run.results + "/" + run.results + to_string(i) + ".png";
+        imwrite(name, image);
+    }
+
+    //Print result
+    newFile << "Positives " << positives << "\n";
+    newFile << "Negatives " << negatives << "\n";
+    {
+        lock_guard<mutex> lock(run.outputMutex);
+        if(pending.writer != NULL)
+        {
+            double milliseconds = duration_cast<std::chrono::duration<double, std::milli>>(t2 - pending.start).count();
+            pending.writer->write(pending.imageName, i, classifier.nests, milliseconds);
+        }
+        if(run.geoReference != NULL)
+        {
+            int newNests = run.geoReference->addNests(pending.imageName, image.size(), classifier.nests,
+                                                      parameters.threshold);
+            newFile << "New georeferenced nests " << newNests << "\n";
+        }
+        run.log << newFile.str();
+        run.totalPositives += positives;
+        run.totalNegatives += negatives;
+        run.totalTime += duration;
+        run.totalSkipped += pending.skipped;
+    }
+
+    classifier.nests.clear();
+}
+
+/*
+ * Flag to decode an image directly at the proposal scale, -1 when the decoder can not reduce it by that factor
+ */
+static int reducedDecodeFlag(float scale)
+{
+    if(scale == 0.5f)
+        return IMREAD_REDUCED_COLOR_2;
+    if(scale == 0.25f)
+        return IMREAD_REDUCED_COLOR_4;
+    if(scale == 0.125f)
+        return IMREAD_REDUCED_COLOR_8;
+    return -1;
+}
+
+/*
+ * Positions of the tiles along one side of a mosaic, the last tile is aligned with the border
+ */
+static vector<int> tileStarts(int length, int tileSize, int step)
+{
+    vector<int> starts;
+    for(int position = 0; ; position += step)
+    {
+        if(position + tileSize >= length)
+        {
+            int last = std::max(0, length - tileSize);
+            if(starts.empty() || starts.back() != last)
+                starts.push_back(last);
+            break;
+        }
+        starts.push_back(position);
+    }
+    return starts;
+}
+
+/*
+ * Adds the nests of a tile to the nests of the mosaic. A nest intersecting a nest of a neighbouring tile is only kept
+ * if its probability is higher, as the classifier does within an image. Only the tiles on the left and above overlap
+ * the tile, the others are not compared.
+ */
+static void stitchTile(vector<vector<Nest>> &tileNests, int tile, int columns, const vector<Nest> &found, Point offset)
+{
+    int neighbours[4] = {tile - 1, tile - columns - 1, tile - columns, tile - columns + 1};
+    for(vector<Nest>::const_iterator it = found.begin(); it != found.end(); ++it)
+    {
+        Nest nest = *it;
+        nest.rect += offset;
+        bool isNewElement = true;
+        for(int r = 0; r < 4 && isNewElement; ++r)
+        {
+            if(neighbours[r] < 0)
+                continue;
+            vector<Nest> &other = tileNests[neighbours[r]];
+            for(vector<Nest>::iterator o = other.begin(); o != other.end(); ++o)
+            {
+                if((o->rect & nest.rect).area() > 0 && nest.probability <= o->probability)
+                {
+                    isNewElement = false;
+                    break;
+                }
+            }
+        }
+        if(!isNewElement)
+            continue;
+
+        //Delete the nests of the neighbours with a lower probability
+        for(int r = 0; r < 4; ++r)
+        {
+            if(neighbours[r] < 0)
+                continue;
+            vector<Nest> &other = tileNests[neighbours[r]];
+            for(vector<Nest>::iterator o = other.begin(); o != other.end();)
+            {
+                if((o->rect & nest.rect).area() > 0)
+                    o = other.erase(o);
+                else
+                    ++o;
+            }
+        }
+        tileNests[tile].push_back(nest);
+    }
+}
+
+/*
+ * Classifies a mosaic larger than the memory tile by tile. The proposals of each tile are generated while the
+ * previous one is scored, and the rows of the mosaic already processed are released, so the memory used depends on
+ * the size of the tiles and not on the size of the mosaic.
+ */
+static void classifyMosaic(Classifier &classifier, Run &run, const string &mosaicName, int position,
+                           ResultsWriter *writer, SandMask &sandMask)
+{
+    const Parameters &parameters = run.parameters;
+    MosaicReader mosaic;
+    if(!mosaic.open(run.imageDir + mosaicName))
+    {
+        lock_guard<mutex> lock(run.outputMutex);
+        run.log << mosaicName << " is not a binary PPM mosaic, skipped\n";
+        return;
+    }
+    int number = ++run.imageNumber;
+    if(position > 0)
+        number = position;
+    high_resolution_clock::time_point start = high_resolution_clock::now();
+
+    Size size = mosaic.getSize();
+    int step = std::max(1, parameters.tileSize - parameters.tileOverlap);
+    vector<int> xs = tileStarts(size.width, parameters.tileSize, step);
+    vector<int> ys = tileStarts(size.height, parameters.tileSize, step);
+    int columns = (int) xs.size();
+    vector<vector<Nest>> tileNests(xs.size() * ys.size());
+    int previousTile = -1;
+    Point previousOffset;
+    for(int r = 0; r < (int) ys.size(); ++r)
+    {
+        for(int c = 0; c < columns; ++c)
+        {
+            Rect tileRect(xs[c], ys[r], std::min(parameters.tileSize, size.width - xs[c]),
+                          std::min(parameters.tileSize, size.height - ys[r]));
+            Mat tile;
+            {
+                ScopedTimer timer("load tile");
+                tile = mosaic.readTile(tileRect);
+            }
+            Mat mask;
+            if(parameters.sandMask)
+                mask = sandMask.compute(tile);
+            classifier.Propose(tile, mask);
+
+            if(previousTile >= 0)
+            {
+                ScopedTimer timer("collect");
+                classifier.Collect();
+                stitchTile(tileNests, previousTile, columns, classifier.nests, previousOffset);
+            }
+            previousTile = r * columns + c;
+            previousOffset = tileRect.tl();
+        }
+
+        //The next row of tiles starts below the rows which are not going to be read again
+        if(r + 1 < (int) ys.size())
+            mosaic.release(ys[r + 1]);
+    }
+    {
+        ScopedTimer timer("collect");
+        classifier.Collect();
+        stitchTile(tileNests, previousTile, columns, classifier.nests, previousOffset);
+    }
+    classifier.nests.clear();
+    mosaic.close();
+
+    vector<Nest> nests;
+    int positives = 0;
+    for(vector<vector<Nest>>::iterator it = tileNests.begin(); it != tileNests.end(); ++it)
+    {
+        for(vector<Nest>::iterator n = it->begin(); n != it->end(); ++n)
+        {
+            if(n->probability >= parameters.threshold)
+                positives++;
+            nests.push_back(*n);
+        }
+    }
+    high_resolution_clock::time_point end = high_resolution_clock::now();
+
+    lock_guard<mutex> lock(run.outputMutex);
+    if(writer != NULL)
+        writer->write(mosaicName, number, nests, duration_cast<std::chrono::duration<double, std::milli>>(
+                end - start).count());
+    long duration = std::chrono::duration_cast<std::chrono::minutes>(end - start).count();
+    run.log << "Mosaic " << number << " " << mosaicName << " " << size.width << "x" << size.height << ", "
+            << xs.size() * ys.size() << " tiles\n";
+    run.log << "Time taken: " << duration << " \n";
+    run.log << "Positives " << positives << "\n";
+    run.log << "Negatives " << nests.size() - positives << "\n";
+    run.totalPositives += positives;
+    run.totalNegatives += (int) nests.size() - positives;
+    run.totalTime += (int) duration;
+}
+
+/*
+ * Format of the structured results of the run
+ */
+static ResultsWriter::Format resultsFormat(const Run &run)
+{
+    return run.resultsExtension == ".csv" ? ResultsWriter::CSV : ResultsWriter::JSON_LINES;
+}
+
+/*
+ * Claims the next batch of the work queue. While the other workers hold claims the queue is not finished, so the
+ * worker waits in case one of them stops and its claims expire.
+ */
+static bool claimBatch(Run &run, Batch &batch)
+{
+    while(!run.queue->claim(batch.owner, batch.claimed, batch.images, batch.first))
+    {
+        if(run.queue->isFinished())
+            return false;
+        this_thread::sleep_for(seconds(10));
+    }
+    batch.next = 0;
+    if(!run.resultsExtension.empty())
+    {
+        batch.shardFile = run.imageDir + run.results + "/shards/" + batch.claimed + ".tmp";
+        batch.writer = new ResultsWriter(batch.shardFile, resultsFormat(run), false);
+    }
+    lock_guard<mutex> lock(run.outputMutex);
+    run.log << "Claimed " << batch.claimed << ", " << batch.images.size() << " images\n";
+    return true;
+}
+
+/*
+ * Moves the detections of a finished batch to the shards folder and marks the batch as done. A shard written again
+ * by a worker which took over the claim replaces the previous one, so the images are never written twice. The
+ * georeferenced nests of the process are written before the batch is done, such that the merge finds them.
+ */
+static void completeBatch(Run &run, Batch &batch)
+{
+    if(batch.claimed.empty())
+        return;
+    string batchName = batch.claimed.substr(0, batch.claimed.find('@'));
+    if(batch.writer != NULL)
+    {
+        delete batch.writer;
+        batch.writer = NULL;
+        string shard = run.imageDir + run.results + "/shards/" + batchName + run.resultsExtension;
+        rename(batch.shardFile.c_str(), shard.c_str());
+    }
+    if(run.geoReference != NULL)
+    {
+        string geoShard = run.imageDir + run.results + "/shards/geo/" + run.worker + ".csv";
+        lock_guard<mutex> lock(run.outputMutex);
+        if(run.geoReference->write(geoShard + ".tmp"))
+            rename((geoShard + ".tmp").c_str(), geoShard.c_str());
+    }
+    if(!run.queue->complete(batch.claimed))
+    {
+        lock_guard<mutex> lock(run.outputMutex);
+        run.log << batchName << " expired and was taken by another worker\n";
+    }
+    batch.claimed.clear();
+}
+
+/*
+ * Next image of the worker, from the images of the folder shared by the threads or from the batch claimed in the
+ * work queue. The position of the image in the list of the queue numbers it across processes, 0 without queue.
+ */
+static bool takeImage(Run &run, Batch &batch, string &imageName, int &position)
+{
+    if(run.queue == NULL)
+    {
+        unsigned long index = run.nextImage++;
+        if(index >= run.imageNames.size())
+            return false;
+        imageName = run.imageNames[index];
+        position = 0;
+        return true;
+    }
+    if(batch.claimed.empty() || batch.next >= batch.images.size())
+        return false;
+    run.queue->renew(batch.claimed);
+    position = batch.first + (int) batch.next;
+    imageName = batch.images[batch.next++];
+    return true;
+}
+
+/*
+ * Classifies the images of the run not taken yet by other workers. The proposals of each image are generated while
+ * the classifier is still scoring the previous one.
+ */
+static void classifyImages(Classifier &classifier, Run &run, const string &owner)
+{
+    PendingImage previous;
+    bool hasPrevious = false;
+    SandMask sandMask(run.parameters);
+    Batch batch;
+    batch.owner = owner;
+    batch.writer = NULL;
+    while(true)
+    {
+        string imageName;
+        int position;
+        if(!takeImage(run, batch, imageName, position))
+        {
+            //A batch is only done once the nests of its last image are written
+            if(hasPrevious)
+                finishImage(classifier, run, previous);
+            hasPrevious = false;
+            if(run.queue == NULL)
+                break;
+            completeBatch(run, batch);
+            if(!claimBatch(run, batch))
+                break;
+            continue;
+        }
+        ResultsWriter *writer = run.queue != NULL ? batch.writer : run.writer;
+
+        //Mosaics are classified in tiles
+        if(run.parameters.tileSize > 0)
+        {
+            if(imageName[0] != '.')
+                classifyMosaic(classifier, run, imageName, position, writer, sandMask);
+            continue;
+        }
+
+        PendingImage current;
+        current.imageName = imageName;
+        current.writer = writer;
+        String imageFile = run.imageDir + current.imageName;
+
+        //Load image, the content of the file identifies the image in the cache
+        vector<uchar> bytes;
+        {
+            ScopedTimer timer("load image");
+            ifstream file(imageFile.c_str(), ios::binary);
+            bytes.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+        }
+        if(bytes.empty())
+            continue;
+
+        //Without poses and survey the key only depends on the file, the images found in the cache are not decoded
+        current.cached = false;
+        string proposalKey;
+        if(run.cache != NULL && run.geoReference == NULL && run.registration == NULL)
+        {
+            cacheKeys(run, bytes, 1, Mat(), proposalKey, current.nestKey);
+            current.cached = run.cache->loadNests(current.nestKey, current.nests);
+        }
+        if(!current.cached)
+        {
+            ScopedTimer timer("decode image");
+            current.image = imdecode(bytes, IMREAD_COLOR);
+            if(!current.image.data)
+                continue;
+        }
+        current.number = ++run.imageNumber;
+        if(position > 0)
+            current.number = position;
+        current.start = high_resolution_clock::now();
+        current.scale = 1;
+        current.skipped = 0;
+        current.sandFraction = 1;
+        current.prunedFraction = 0;
+        if(current.cached)
+        {
+            if(hasPrevious)
+                finishImage(classifier, run, previous);
+            previous = current;
+            hasPrevious = true;
+            continue;
+        }
+
+        //Rescale the image to the target ground resolution, such that the nests have the same size in pixels whatever
+        //the altitude of the drone
+        Mat detectionImage = current.image;
+        CameraPose pose;
+        if(run.parameters.targetGsd > 0)
+        {
+            if(run.geoReference->getPose(current.imageName, pose))
+            {
+                ScopedTimer timer("normalise resolution");
+                double scale = run.geoReference->getGroundSampling(pose) / run.parameters.targetGsd;
+                resize(current.image, detectionImage, Size(), scale, scale, scale < 1 ? INTER_AREA : INTER_LINEAR);
+                current.scale = (double) detectionImage.cols / current.image.cols;
+            }
+            else
+            {
+                lock_guard<mutex> lock(run.outputMutex);
+                run.log << "No pose for " << current.imageName << ", processed at the resolution of the camera\n";
+            }
+        }
+
+        //Generate the proposals, the mask of the survey mode only keeps the ground not seen yet
+        Mat mask;
+        if(run.registration != NULL)
+        {
+            ScopedTimer timer("survey registration");
+            mask = run.registration->update(current.image);
+            current.skipped = run.registration->getSkippedFraction();
+            if(current.scale != 1)
+                resize(mask, mask, detectionImage.size(), 0, 0, INTER_NEAREST);
+        }
+        //With poses or survey the key also holds the scale and the mask, which need the decoded image
+        if(run.cache != NULL && proposalKey.empty())
+        {
+            cacheKeys(run, bytes, current.scale, mask, proposalKey, current.nestKey);
+            current.cached = run.cache->loadNests(current.nestKey, current.nests);
+        }
+
+        //Only the sand can contain nests, the sea and the vegetation are left out of the mask
+        if(run.parameters.sandMask && !current.cached)
+        {
+            Mat sand = sandMask.compute(detectionImage);
+            if(mask.empty())
+                mask = sand;
+            else
+                bitwise_and(mask, sand, mask);
+            current.sandFraction = sandMask.getSandFraction();
+        }
+
+        //The proposals in the cache are only scored, which is what a new model needs
+        vector<Rect> proposals;
+        if(!current.cached && run.cache != NULL && run.cache->loadProposals(proposalKey, proposals))
+            classifier.Propose(detectionImage, proposals);
+        else if(!current.cached)
+        {
+            //The JPEG decoder scales the DCT blocks down, which is cheaper than resizing the full image
+            Mat reduced;
+            if(run.parameters.decodeReduced && current.scale == 1)
+            {
+                ScopedTimer timer("load reduced image");
+                reduced = imdecode(bytes, reducedDecodeFlag(run.parameters.proposalScale));
+            }
+            current.prunedFraction = classifier.Propose(detectionImage, mask, reduced);
+            if(run.cache != NULL)
+                run.cache->saveProposals(proposalKey, classifier.getProposals());
+        }
+
+        if(hasPrevious)
+            finishImage(classifier, run, previous);
+        previous = current;
+        hasPrevious = true;
+    }
+}
+
+/*
+ * Nests of the georeferenced shards of the processes, the nests seen by several of them are merged again such that
+ * each physical nest is written once
+ */
+static bool mergeGeoShards(const Run &run)
+{
+    const Parameters &parameters = run.parameters;
+    string folder = run.imageDir + run.results;
+    vector<string> shards;
+    DIR* dir;
+    struct dirent *ent;
+    if((dir = opendir((folder + "/shards/geo").c_str())) != NULL)
+    {
+        while((ent = readdir(dir)) != NULL)
+        {
+            string name = ent->d_name;
+            if(name.size() > 4 && name.compare(name.size() - 4, string::npos, ".csv") == 0)
+                shards.push_back(name);
+        }
+        closedir(dir);
+    }
+    std::sort(shards.begin(), shards.end());
+
+    GeoReference geoReference(parameters.focalLength, Point2d(parameters.principalX, parameters.principalY),
+                              parameters.dedupRadius);
+    for(vector<string>::iterator it = shards.begin(); it != shards.end(); ++it)
+    {
+        if(geoReference.merge(folder + "/shards/geo/" + *it) < 0)
+            return false;
+    }
+    string merged = folder + "/nests_geo.csv";
+    string temporary = merged + ".tmp";
+    if(!geoReference.write(temporary))
+        return false;
+    return rename(temporary.c_str(), merged.c_str()) == 0;
+}
+
+/*
+ * Concatenates the detections of the batches in the order of the images. Every CSV shard starts with the header,
+ * which is only kept once.
+ */
+static bool mergeShards(const Run &run)
+{
+    if(run.geoReference != NULL && !mergeGeoShards(run))
+        return false;
+    if(run.resultsExtension.empty())
+        return true;
+    string folder = run.imageDir + run.results;
+    vector<string> shards;
+    DIR* dir;
+    struct dirent *ent;
+    if((dir = opendir((folder + "/shards").c_str())) != NULL)
+    {
+        while((ent = readdir(dir)) != NULL)
+        {
+            string name = ent->d_name;
+            if(name.size() > run.resultsExtension.size() &&
+               name.compare(name.size() - run.resultsExtension.size(), string::npos, run.resultsExtension) == 0)
+                shards.push_back(name);
+        }
+        closedir(dir);
+    }
+    std::sort(shards.begin(), shards.end());
+
+    string merged = folder + "/detections" + run.resultsExtension;
+    string temporary = merged + ".tmp";
+    {
+        ofstream output(temporary.c_str(), ios::out | ios::trunc);
+        if(!output.is_open())
+            return false;
+        bool header = false;
+        for(vector<string>::iterator it = shards.begin(); it != shards.end(); ++it)
+        {
+            ifstream input((folder + "/shards/" + *it).c_str());
+            string line;
+            if(header && resultsFormat(run) == ResultsWriter::CSV)
+                getline(input, line);
+            while(getline(input, line))
+                output << line << "\n";
+            header = true;
+        }
+        if(!output)
+            return false;
+    }
+    return rename(temporary.c_str(), merged.c_str()) == 0;
+}
+
+/*
+ * Scores the crops of a held-out folder with the FP32 network and the selected backend.
+ */
+static void evaluateFolder(Classifier &reference, Classifier &candidate, const string &folder, bool positive,
+                           float threshold, Evaluation &evaluation)
+{
+    DIR* dir;
+    struct dirent *ent;
+    if((dir = opendir(folder.c_str())) == NULL)
+    {
+        cerr << "Could not open " << folder << endl;
+        return;
+    }
+    while((ent = readdir(dir)) != NULL)
+    {
+        Mat crop = imread(folder + "/" + ent->d_name, 1);
+        if(!crop.data)
+            continue;
+
+        high_resolution_clock::time_point t1 = high_resolution_clock::now();
+        float referenceProbability = reference.Score(crop);
+        high_resolution_clock::time_point t2 = high_resolution_clock::now();
+        float candidateProbability = candidate.Score(crop);
+        high_resolution_clock::time_point t3 = high_resolution_clock::now();
+
+        bool referencePositive = referenceProbability >= threshold;
+        bool candidatePositive = candidateProbability >= threshold;
+        double delta = fabs(referenceProbability - candidateProbability);
+        evaluation.samples++;
+        evaluation.referenceCorrect += referencePositive == positive;
+        evaluation.candidateCorrect += candidatePositive == positive;
+        evaluation.changedDecisions += referencePositive != candidatePositive;
+        evaluation.totalDelta += delta;
+        evaluation.maxDelta = std::max(evaluation.maxDelta, delta);
+        evaluation.referenceTime += duration_cast<std::chrono::duration<double, std::milli>>(t2 - t1).count();
+        evaluation.candidateTime += duration_cast<std::chrono::duration<double, std::milli>>(t3 - t2).count();
+    }
+    closedir(dir);
+}
+
+/*
+ * Prints the accuracy of the selected backend against FP32 over the held-out crops.
+ */
+static int evaluateBackend(const string &model, const string &weights, const Parameters &parameters)
+{
+    Parameters referenceParameters = parameters;
+    referenceParameters.backend = "caffe";
+    Classifier reference(model, weights, referenceParameters);
+    Classifier candidate(model, weights, parameters);
+
+    Evaluation evaluation = Evaluation();
+    if(!parameters.evaluatePositive.empty())
+        evaluateFolder(reference, candidate, parameters.evaluatePositive, true, parameters.threshold, evaluation);
+    if(!parameters.evaluateNegative.empty())
+        evaluateFolder(reference, candidate, parameters.evaluateNegative, false, parameters.threshold, evaluation);
+    if(evaluation.samples == 0)
+    {
+        cerr << "No held-out crops to evaluate" << endl;
+        return 1;
+    }
+
+    double samples = evaluation.samples;
+    cout << "Held-out crops " << evaluation.samples << endl;
+    cout << "FP32 accuracy " << evaluation.referenceCorrect / samples << endl;
+    cout << parameters.backend << " accuracy " << evaluation.candidateCorrect / samples << " (delta "
+         << (evaluation.candidateCorrect - evaluation.referenceCorrect) / samples << ")" << endl;
+    cout << "Changed decisions " << evaluation.changedDecisions << endl;
+    cout << "Probability delta mean " << evaluation.totalDelta / samples << " max " << evaluation.maxDelta << endl;
+    cout << "Time per crop FP32 " << evaluation.referenceTime / samples << " ms, " << parameters.backend << " "
+         << evaluation.candidateTime / samples << " ms" << endl;
+    return 0;
+}
+
+/*
+ * Compares the speed of the inference engines on the same model and crops, and their probabilities against caffe.
+ */
+static int benchmarkEngines(const string &model, const string &weights, const Parameters &parameters)
+{
+    vector<Mat> crops;
+    DIR* dir;
+    struct dirent *ent;
+    if((dir = opendir(parameters.benchmark.c_str())) != NULL)
+    {
+        while((ent = readdir(dir)) != NULL)
+        {
+            Mat crop = imread(parameters.benchmark + "/" + ent->d_name, 1);
+            if(crop.data)
+                crops.push_back(crop);
+        }
+        closedir(dir);
+    }
+    if(crops.empty())
+    {
+        cerr << "No crops to benchmark in " << parameters.benchmark << endl;
+        return 1;
+    }
+
+    //The int8 engine needs the calibration crops
+    vector<string> backends;
+    backends.push_back("caffe");
+    if(!parameters.calibrationDir.empty())
+        backends.push_back("int8");
+#ifdef WITH_OPENCV_DNN
+    backends.push_back("opencv");
+#endif
+
+    unsigned long batchSize = (unsigned long) std::max(1, parameters.batchSize);
+    cout << crops.size() << " crops in batches of " << batchSize << endl;
+    cout << "engine,load ms,ms per crop,max probability delta,changed decisions" << endl;
+    vector<float> reference;
+    for(vector<string>::iterator it = backends.begin(); it != backends.end(); ++it)
+    {
+        Parameters engineParameters = parameters;
+        engineParameters.backend = *it;
+        high_resolution_clock::time_point t1 = high_resolution_clock::now();
+        IInferenceEngine *engine = Classifier::createEngine(model, weights, engineParameters);
+        high_resolution_clock::time_point t2 = high_resolution_clock::now();
+
+        //The first batch allocates the buffers of the engine, so it is not measured
+        vector<float> probabilities;
+        engine->submit(crops[0]);
+        engine->collect(probabilities);
+
+        high_resolution_clock::time_point t3 = high_resolution_clock::now();
+        vector<float> results;
+        for(unsigned long r = 0; r < crops.size(); ++r)
+        {
+            engine->submit(crops[r]);
+            if((r + 1) % batchSize == 0 || r + 1 == crops.size())
+            {
+                engine->collect(probabilities);
+                results.insert(results.end(), probabilities.begin(), probabilities.end());
+            }
+        }
+        high_resolution_clock::time_point t4 = high_resolution_clock::now();
+        delete engine;
+
+        if(reference.empty())
+            reference = results;
+        float maxDelta = 0;
+        int changedDecisions = 0;
+        for(unsigned long r = 0; r < results.size(); ++r)
+        {
+            maxDelta = std::max(maxDelta, (float) fabs(results[r] - reference[r]));
+            changedDecisions += (results[r] >= parameters.threshold) != (reference[r] >= parameters.threshold);
+        }
+        cout << *it << "," << duration_cast<std::chrono::duration<double, std::milli>>(t2 - t1).count() << ","
+             << duration_cast<std::chrono::duration<double, std::milli>>(t4 - t3).count() / crops.size() << ","
+             << maxDelta << "," << changedDecisions << endl;
+    }
+    return 0;
+}
+
+/*
+ * Records the outputs of the golden corpus or verifies the current build against them, the parameters of the
+ * recording are used for the verification unless they are overridden in the command line
+ */
+static int regressionCorpus(int argc, char **argv, const string &model, const string &weights, Parameters parameters)
+{
+    Regression recorded(parameters.corpus, parameters);
+    if(parameters.regression == "verify")
+    {
+        vector<string> arguments;
+        if(!parameters.load(recorded.getParametersFile()) || !parameters.parseArguments(argc, argv, arguments))
+        {
+            cerr << "Could not read the parameters of the recording " << recorded.getParametersFile() << endl;
+            return 1;
+        }
+    }
+
+    Classifier classifier(model, weights, parameters);
+    Regression regression(parameters.corpus, parameters);
+    if(parameters.regression == "record")
+        return regression.record(classifier);
+
+    int failures = regression.verify(classifier, cout);
+    cout << (failures == 0 ? "PASS" : "FAIL") << endl;
+    return failures == 0 ? 0 : 1;
+}
+
+/*
+ * Takes the nests of a request from the classifier and sends them to its client
+ */
+static void collectRequest(Classifier &classifier, DetectionServer &server, const DetectionJob &job,
+                           high_resolution_clock::time_point start)
+{
+    {
+        ScopedTimer timer("collect");
+        classifier.Collect();
+    }
+    double milliseconds = duration_cast<std::chrono::duration<double, std::milli>>(
+            high_resolution_clock::now() - start).count();
+    server.reply(job, classifier.nests, milliseconds);
+    classifier.nests.clear();
+}
+
+/*
+ * Classifies the requests of all the clients of the server. The requests are proposed one after the other while the
+ * previous ones are scored, so the scoring thread fills its batches across them. The results already scored are sent
+ * before the next request is proposed, and the worker only waits for the others when no request is queued.
+ */
+static void serveRequests(Classifier &classifier, DetectionServer &server, const Parameters &parameters)
+{
+    SandMask sandMask(parameters);
+    deque<pair<DetectionJob, high_resolution_clock::time_point>> waiting;
+    while(true)
+    {
+        while(!waiting.empty() && classifier.hasCompleted())
+        {
+            collectRequest(classifier, server, waiting.front().first, waiting.front().second);
+            waiting.pop_front();
+        }
+        DetectionJob job;
+        if(waiting.empty())
+        {
+            if(!server.next(job))
+                break;
+        }
+        else if(!server.tryNext(job))
+        {
+            collectRequest(classifier, server, waiting.front().first, waiting.front().second);
+            waiting.pop_front();
+            continue;
+        }
+
+        high_resolution_clock::time_point start = high_resolution_clock::now();
+        Mat image;
+        {
+            ScopedTimer timer("load image");
+            image = job.path.empty() ? imdecode(job.content, IMREAD_COLOR) : imread(job.path, IMREAD_COLOR);
+        }
+        if(!image.data)
+        {
+            server.fail(job, "could not read the image");
+            continue;
+        }
+        Mat mask;
+        if(parameters.sandMask)
+            mask = sandMask.compute(image);
+        classifier.Propose(image, mask);
+        job.content.clear();
+        waiting.push_back(make_pair(job, start));
+    }
+}
+
+/*
+ * Resident server, the model is loaded once and shared by the workers
+ */
+static int serveClients(const string &model, const string &weights, const Parameters &parameters)
+{
+    high_resolution_clock::time_point start = high_resolution_clock::now();
+    Classifier classifier(model, weights, parameters);
+    double loadTime = duration_cast<std::chrono::duration<double, std::milli>>(
+            high_resolution_clock::now() - start).count();
+    DetectionServer server(parameters.serve);
+    if(!server.start())
+    {
+        cerr << "Could not listen on the socket " << parameters.serve << endl;
+        return 1;
+    }
+    cout << "Model loaded in " << loadTime << " ms, serving on " << parameters.serve << endl;
+
+    int workers = parameters.workers > 0 ? parameters.workers : 1;
+    vector<thread> threads;
+    for(int r = 1; r < workers; ++r)
+    {
+        threads.push_back(thread([&]()
+        {
+            Classifier workerClassifier(classifier, parameters);
+            serveRequests(workerClassifier, server, parameters);
+        }));
+    }
+    serveRequests(classifier, server, parameters);
+    for(vector<thread>::iterator it = threads.begin(); it != threads.end(); ++it)
+        it->join();
+    cout << "Server stopped" << endl;
+    return 0;
+}
+
+/*
+ * Writes the statistics of the stages and the trace of the run when they were requested
+ */
+static void writeProfile(const Parameters &parameters, ostream &output)
+{
+    if(parameters.profile.empty())
+        return;
+    Profiler::writeSummary(output);
+    if(!Profiler::writeTrace(parameters.profile))
+        cerr << "Could not write the trace " << parameters.profile << endl;
+}
+
 int main(int argc, char** argv)
 {
     help();
     //Verify parameters
-    if(argc != 5)
+    Run run;
+    Parameters &parameters = run.parameters;
+    vector<string> arguments;
+    bool parsed = parameters.parseArguments(argc, argv, arguments);
+    bool evaluate = !parameters.evaluatePositive.empty() || !parameters.evaluateNegative.empty();
+    bool benchmark = !parameters.benchmark.empty();
+    bool regression = !parameters.regression.empty();
+    bool serve = !parameters.serve.empty();
+    bool tune = !parameters.tune.empty();
+    if(!parsed || arguments.size() != (evaluate || benchmark || regression || serve || tune ? 2u : 4u))
     {
         cerr << "Error in parameters" << endl;
         return 1;
     }
 
+    //Threads shared by the parallel loops of every worker, the workers run tasks too while they wait for them
+    TaskPool::configure(parameters.poolThreads);
+    if(parameters.backend == "int8" && parameters.calibrationDir.empty())
+    {
+        cerr << "The int8 backend requires a folder of calibration crops, --calibrationDir=folder" << endl;
+        return 1;
+    }
+#ifndef WITH_OPENCV_DNN
+    if(parameters.backend == "opencv")
+    {
+        cerr << "The opencv backend requires building with WITH_OPENCV_DNN" << endl;
+        return 1;
+    }
+#endif
+    if(parameters.decodeReduced && reducedDecodeFlag(parameters.proposalScale) < 0)
+    {
+        cerr << "Images can only be decoded reduced with a proposal scale of 0.5, 0.25 or 0.125" << endl;
+        return 1;
+    }
+    if(parameters.tileSize > 0 && (parameters.tileSize <= parameters.tileOverlap || parameters.survey))
+    {
+        cerr << "The tiles must be larger than their overlap, and the survey mode does not apply to mosaics" << endl;
+        return 1;
+    }
+    if(!parameters.queueDir.empty() && parameters.survey)
+    {
+        cerr << "The survey mode registers consecutive images, so it can not be sharded with --queueDir" << endl;
+        return 1;
+    }
+    if(regression && parameters.corpus.empty())
+    {
+        cerr << "The golden corpus requires its folder, --corpus=dir" << endl;
+        return 1;
+    }
+    if(tune && parameters.tuned.empty())
+    {
+        cerr << "The calibration writes its configuration to a file, --tuned=file" << endl;
+        return 1;
+    }
+
+    //Stage timers and counters, only recorded when a trace is requested
+    Profiler::enable(!parameters.profile.empty());
+    if(tune || regression || benchmark || evaluate || serve)
+    {
+        int status;
+        if(tune)
+        {
+            Tuner tuner(parameters.tune, parameters);
+            status = tuner.run(arguments[0], arguments[1], cout);
+        }
+        else if(regression)
+            status = regressionCorpus(argc, argv, arguments[0], arguments[1], parameters);
+        else if(benchmark)
+            status = benchmarkEngines(arguments[0], arguments[1], parameters);
+        else if(evaluate)
+            status = evaluateBackend(arguments[0], arguments[1], parameters);
+        else
+            status = serveClients(arguments[0], arguments[1], parameters);
+        writeProfile(parameters, cout);
+        return status;
+    }
+
+    //The ground resolution comes from the altitude of the poses, and the nest size bounds in metres become pixel bounds
+    //at that resolution
+    if(parameters.targetGsd > 0 && parameters.poseFile.empty())
+    {
+        cerr << "The ground resolution normalisation requires the poses of the images, --poseFile=poses.csv" << endl;
+        return 1;
+    }
+    if((parameters.minNestSize > 0 || parameters.maxNestSize > 0) && parameters.targetGsd <= 0)
+    {
+        cerr << "The nest size bounds in metres require a target ground resolution, --targetGsd=metres" << endl;
+        return 1;
+    }
+    if(parameters.minNestSize > 0)
+    {
+        parameters.minRegionWidth = (int) lround(parameters.minNestSize / parameters.targetGsd);
+        parameters.minRegionHeight = parameters.minRegionWidth;
+    }
+    if(parameters.maxNestSize > 0)
+    {
+        parameters.maxRegionWidth = (int) lround(parameters.maxNestSize / parameters.targetGsd);
+        parameters.maxRegionHeight = parameters.maxRegionWidth;
+    }
+
     //Load parameters
-    string model = argv[1];
-    string weights = argv[2];
-    string imageDir = argv[3];
-    string results = argv[4];
-    Mat image;
+    string model = arguments[0];
+    string weights = arguments[1];
+    run.imageDir = arguments[2];
+    run.results = arguments[3];
+    const string &imageDir = run.imageDir;
+    const string &results = run.results;
 
-    //Create classifier
-    Classifier classifier(model, weights);
-    ofstream newFile;
-    newFile.open(imageDir + results +  "/nohup.out");
-    int i = 0;
-    int totalPositives = 0;
-    int totalNegatives = 0;
-    int totalTime = 0;
+    //Create classifier, the weights are loaded once and shared by the classifiers of the other workers
+    high_resolution_clock::time_point start = high_resolution_clock::now();
+    Classifier classifier(model, weights, parameters);
+    double loadTime = duration_cast<std::chrono::duration<double, std::milli>>(
+            high_resolution_clock::now() - start).count();
 
-    DIR* dir;
-    struct dirent *ent;
-    if( (dir = opendir(imageDir.c_str())) != NULL )
+    //Sharded runs write the log and the results of each worker apart, the name of the worker identifies its claims
+    string suffix;
+    if(!parameters.queueDir.empty())
     {
-        while ((ent = readdir(dir)) != NULL)
+        run.worker = parameters.workerName;
+        if(run.worker.empty())
         {
-            String imageFile = imageDir + ent->d_name;
+            char host[256] = "";
+            gethostname(host, sizeof(host) - 1);
+            run.worker = string(host) + "-" + to_string(getpid());
+        }
+        suffix = "." + run.worker;
+    }
+    run.log.open(imageDir + results + "/nohup" + suffix + ".out");
+    parameters.print(run.log);
+    run.log << "Model loaded in " << loadTime << " ms\n";
+    run.log << "Inference engine " << parameters.backend << ", batches of " << parameters.batchSize << "\n";
+    if(parameters.backend == "int8")
+        run.log << "Network quantized to int8 with the crops of " << parameters.calibrationDir << "\n";
 
-            //Load image
-            image = imread(imageFile, 1);
+    //Structured results, one row per detection. With the cache the images of an interrupted run are written again, so
+    //the file starts empty
+    run.writer = NULL;
+    bool append = parameters.cacheDir.empty();
+    if(parameters.resultsFormat == "jsonl")
+        run.resultsExtension = ".jsonl";
+    else if(parameters.resultsFormat == "csv")
+        run.resultsExtension = ".csv";
+    else if(parameters.resultsFormat != "none")
+    {
+        cerr << "Unknown results format " << parameters.resultsFormat << endl;
+        return 1;
+    }
 
-            if(!image.data)
-            {
-                continue;
-            }
+    //The batches of a sharded run are written to results/shards and merged by the last worker
+    if(!parameters.queueDir.empty())
+    {
+        mkdir((imageDir + results + "/shards").c_str(), 0755);
+        if(!parameters.poseFile.empty())
+            mkdir((imageDir + results + "/shards/geo").c_str(), 0755);
+    }
+    else if(!run.resultsExtension.empty())
+        run.writer = new ResultsWriter(imageDir + results + "/detections" + run.resultsExtension, resultsFormat(run),
+                                       append);
 
-            i++;
-            newFile << "Image " << i << "\n";
+    //Projection of the nests to the ground, the same nest seen in several images is only reported once
+    run.geoReference = NULL;
+    if(!parameters.poseFile.empty())
+    {
+        if(parameters.focalLength <= 0)
+        {
+            cerr << "The focal length of the camera is required to georeference the nests" << endl;
+            return 1;
+        }
+        run.geoReference = new GeoReference(parameters.focalLength,
+                                            Point2d(parameters.principalX, parameters.principalY),
+                                            parameters.dedupRadius);
+        if(!run.geoReference->loadPoses(parameters.poseFile))
+            return 1;
+    }
+    run.totalPositives = 0;
+    run.totalNegatives = 0;
+    run.totalTime = 0;
+    run.totalSkipped = 0;
 
-            //Classify
-            high_resolution_clock::time_point t1 = high_resolution_clock::now();
-            int result = classifier.Classify(image);
-            high_resolution_clock::time_point t2 = high_resolution_clock::now();
+    //Results cache, the fingerprints hold everything the proposals and the nests depend on besides the image
+    run.cache = NULL;
+    if(!parameters.cacheDir.empty())
+    {
+        run.cache = new ResultCache(parameters.cacheDir);
+        if(!run.cache->isOpen())
+        {
+            cerr << "Could not create the cache " << parameters.cacheDir << endl;
+            return 1;
+        }
+        ostringstream proposal;
+        proposal << parameters.method << " " << parameters.windowSize << " " << classifier.getInputSize() << " "
+                 << parameters.sigma << " " << parameters.k << " " << parameters.minSize << " " << parameters.maxRegions
+                 << " " << parameters.proposalScale << " " << parameters.decodeReduced << " "
+                 << parameters.minRegionWidth << " " << parameters.minRegionHeight << " " << parameters.maxRegionWidth
+                 << " " << parameters.maxRegionHeight << " " << parameters.maskFraction << " " << parameters.sandMask
+                 << " " << parameters.sandHueMin << " " << parameters.sandHueMax << " "
+                 << parameters.sandSaturationMax << " " << parameters.sandValueMin << " " << parameters.sandMaskScale;
+        run.proposalFingerprint = proposal.str();
+        ostringstream nest;
+        nest << ResultCache::hashFile(model) << " " << ResultCache::hashFile(weights) << " " << parameters.backend;
+        if(parameters.backend == "int8")
+            nest << " " << parameters.calibrationDir << " " << parameters.calibrationSamples;
+        run.nestFingerprint = nest.str();
+    }
+
+    //Survey mode: only the ground not seen in the previous images is searched
+    run.registration = NULL;
+    if(parameters.survey)
+        run.registration = new SurveyRegistration(parameters.surveyMemory, parameters.surveyFeatures,
+                                                  parameters.surveyScale);
+
+    //Consecutive images must be processed in order to be registered
+    DIR* dir;
+    struct dirent *ent;
+    if( (dir = opendir(imageDir.c_str())) != NULL )
+    {
+        while ((ent = readdir(dir)) != NULL)
+            run.imageNames.push_back(ent->d_name);
+        closedir(dir);
+    }
+    if(parameters.survey)
+        std::sort(run.imageNames.begin(), run.imageNames.end());
+    run.nextImage = 0;
+    run.imageNumber = 0;
 
-            auto duration = std::chrono::duration_cast<std::chrono::minutes>(t2 - t1).count();
-            newFile << "Time taken: " << duration << " \n";
+    //Sharding: the first process splits the sorted images in batches and the workers claim them from the queue
+    run.queue = NULL;
+    if(!parameters.queueDir.empty())
+    {
+        vector<string> images;
+        for(vector<string>::iterator it = run.imageNames.begin(); it != run.imageNames.end(); ++it)
+        {
+            if((*it)[0] != '.')
+                images.push_back(*it);
+        }
+        std::sort(images.begin(), images.end());
+        run.queue = new WorkQueue(parameters.queueDir, parameters.claimTimeout);
+        if(!run.queue->initialize(images, parameters.queueBatch))
+        {
+            cerr << "Could not create the work queue " << parameters.queueDir
+                 << ", remove it if the process creating it stopped" << endl;
+            return 1;
+        }
+        run.log << "Worker " << run.worker << " sharing the queue " << parameters.queueDir << "\n";
+    }
 
-            //Add rectangles to the image
-            int negatives = 0;
-            int positives = 0;
-            for(vector<Nest>::iterator it = classifier.nests.begin(); it != classifier.nests.end(); ++it)
+    //The survey registration needs the images one after the other, so it is done by a single worker
+    int workers = parameters.workers > 0 && !parameters.survey ? parameters.workers : 1;
+    if(workers == 1)
+        classifyImages(classifier, run, run.worker + "-0");
+    else
+    {
+        vector<thread> threads;
+        for(int r = 0; r < workers; ++r)
+        {
+            threads.push_back(thread([&, r]()
             {
-                Scalar colour;
-                if(it->probability >= 0.5)
-                {
-                    colour = Scalar(0, 255, 0);
-                    positives++;
-                }
-                else
+                high_resolution_clock::time_point workerStart = high_resolution_clock::now();
+                Classifier workerClassifier(classifier, parameters);
+                double workerTime = duration_cast<std::chrono::duration<double, std::milli>>(
+                        high_resolution_clock::now() - workerStart).count();
                 {
-                    colour = Scalar(255, 0, 0);
-                    negatives++;
+                    lock_guard<mutex> lock(run.outputMutex);
+                    run.log << "Worker classifier created in " << workerTime << " ms\n";
                 }
-                rectangle(image, it->rect, colour, 2, LINE_AA, 0);
-                putText(image, to_string(it->probability), it->rect.br(), FONT_HERSHEY_COMPLEX, 1, colour, 2, LINE_AA, 0);
-            }
-
-            classifier.nests.clear();
+                classifyImages(workerClassifier, run, run.worker + "-" + to_string(r));
+            }));
+        }
+        for(vector<thread>::iterator it = threads.begin(); it != threads.end(); ++it)
+            it->join();
+    }
 
-            //Print result
-            newFile << "Positives " << positives << "\n";
-            newFile << "Negatives " << negatives << "\n";
-            totalPositives += positives;
-            totalNegatives += negatives;
-            totalTime += duration;
-            String name = imageDir + results + "/" + results + to_string(i) + ".png";
-            imwrite(name, image);
+    delete run.writer;
+    if(run.queue != NULL)
+    {
+        //Only one of the workers finding the queue finished merges the results at a time, the lock is removed such
+        //that a later run over the same queue merges them again
+        if(run.queue->isFinished() && run.queue->lockMerge())
+        {
+            if(mergeShards(run))
+                run.log << "Results of the workers merged\n";
+            else
+                cerr << "Could not merge the results of the workers" << endl;
+            run.queue->unlockMerge();
         }
+        delete run.queue;
+    }
+    int i = run.imageNumber;
+    if(run.registration != NULL)
+    {
+        run.log << "Total skipped pixels " << (i > 0 ? run.totalSkipped / i : 0) << "\n";
+        delete run.registration;
     }
-    newFile << "Total positives " << totalPositives << "\n";
-    newFile << "Total negatives " << totalNegatives << "\n";
-    newFile << "Total time " << totalTime << "\n";
-    newFile.close();
-}
\ No newline at end of file
+    delete run.cache;
+    if(run.geoReference != NULL)
+    {
+        run.log << "Total georeferenced nests " << run.geoReference->geoNests.size() << "\n";
+        if(parameters.queueDir.empty())
+            run.geoReference->write(imageDir + results + "/nests_geo.csv");
+        delete run.geoReference;
+    }
+    run.log << "Total positives " << run.totalPositives << "\n";
+    run.log << "Total negatives " << run.totalNegatives << "\n";
+    run.log << "Total time " << run.totalTime << "\n";
+    writeProfile(parameters, run.log);
+    run.log.close();
+}
@@ -12,12 +12,27 @@
  */
 
 #include <iostream>
-#include <opencv2/opencv.hpp>
-#include "Classifier/Classifier.h"
+#include <fstream>
+#include <set>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/videoio.hpp>
+#ifdef WITH_GUI
+#include <opencv2/highgui.hpp>
+#endif
+#include "Tracker.h"
+#include "Profiler.h"
+#include "TaskPool.h"
 
 using namespace std;
 using namespace cv;
 
+static mutex outputMutex;
+
 static void help()
 {
     cout
@@ -34,89 +49,238 @@ static void help()
     << "This program detects nests within a video stream."                              << endl
     << "It requires the prototxt file and the weights to initialize the caffe "         << endl
     << "architecture."                                                                  << endl
+    << "Detection parameters can be loaded from a file with --config=file and "         << endl
+    << "overridden with --name=value, e.g. --lkWindow=21 --pyramidLevels=2"             << endl
+    << "Several videos can be given, they are processed at the same time by --workers " << endl
+    << "threads sharing the weights of the network. --display=0 runs without window, "  << endl
+    << "--writeDetections=1 writes the nests of each frame in VideoFile_detections.csv" << endl
+    << "--backend=int8 --calibrationDir=crops runs the network quantized to 8 bits"    << endl
+    << "--profile=trace.json records the time of each stage, see chrome://tracing"      << endl
+    << "The configuration tuned by NestRecognition --tune=dir is loaded by default"    << endl
+    << "--poolThreads=N runs the segmentation and preprocessing loops on N threads"   << endl
+    << "--frameBudget=40 stops scoring the new proposals of a frame after 40 ms, "     << endl
+    << "the most contrasted first, and scores the rest in the next frame"              << endl
     << "Usage:"                                                                         << endl
-    << "./Tracking deploy.prototxt weights.caffemodel InputVideoFile"                   << endl
+    << "./Tracking [options] deploy.prototxt weights.caffemodel VideoFile [VideoFile...]" << endl
     << "------------------------------------------------------------------------------" << endl
     << endl;
 }
 
-int main(int argc, char** argv)
+/*
+ * Detects and tracks the nests of a video, writing the annotated video and/or the detections of each frame.
+ */
+static int processVideo(Tracker &tracker, const string &videoFile, const Parameters &parameters, bool display)
 {
-    help();
-    namedWindow("Main", WINDOW_NORMAL);
-    //Verify parameters
-    if(argc != 4)
-    {
-        cerr << "Error in parameters" << endl;
-        return 1;
-    }
-
-    //Load parameters
-    string model = argv[1];
-    string weights = argv[2];
-    string videoFile = argv[3];
-
-    //Create classifier
-    Classifier classifier(model, weights, ISlideMethod::SELECTIVE);
-
     //Open video file
     VideoCapture cap(videoFile);
 
     if(!cap.isOpened())
     {
-        cerr << "Could not open video" <<endl;
+        lock_guard<mutex> lock(outputMutex);
+        cerr << "Could not open video " << videoFile << endl;
         return -1;
     }
 
     //Prepare video file to be rendered
     //Code based from the OpenCV documentation in: http://docs.opencv.org/doc/tutorials/highgui/video-write/video-write.html
     string::size_type nameFile = videoFile.find_last_of('.');
-    const string finalNameFile = videoFile.substr(0, nameFile) + "_processed" + ".avi";
-    int codecType = static_cast<int>(cap.get(CV_CAP_PROP_FOURCC));
+    const string baseName = videoFile.substr(0, nameFile);
+    VideoWriter outputVideo;
+    if(parameters.writeVideo)
+    {
+        const string finalNameFile = baseName + "_processed" + ".avi";
+        int codecType = static_cast<int>(cap.get(CAP_PROP_FOURCC));
 
-    Size frameSize = Size((int) cap.get(CV_CAP_PROP_FRAME_WIDTH), (int) cap.get(CV_CAP_PROP_FRAME_HEIGHT));
+        Size frameSize = Size((int) cap.get(CAP_PROP_FRAME_WIDTH), (int) cap.get(CAP_PROP_FRAME_HEIGHT));
 
-    VideoWriter outputVideo;
-    outputVideo.open(finalNameFile, codecType, cap.get(CV_CAP_PROP_FPS), frameSize, true);
-    if (!outputVideo.isOpened())
+        outputVideo.open(finalNameFile, codecType, cap.get(CAP_PROP_FPS), frameSize, true);
+        if (!outputVideo.isOpened())
+        {
+            lock_guard<mutex> lock(outputMutex);
+            cerr << "Could not open the output video for write: " << videoFile << endl;
+            return -1;
+        }
+    }
+
+    ofstream detections;
+    if(parameters.writeDetections)
     {
-        cout  << "Could not open the output video for write: " << videoFile << endl;
-        return -1;
+        detections.open(baseName + "_detections.csv");
+        detections << "frame,id,state,x,y,width,height,probability\n";
     }
 
+    //Tracks are not carried from one video to the next one
+    tracker.Reset();
     Mat frame;
-    Mat image;
     int currentFrameNumber = 0;
-    double totalFrames = cap.get(CV_CAP_PROP_FRAME_COUNT);
+    int lateFrames = 0;
+    set<int> countedNests;
+    double totalFrames = cap.get(CAP_PROP_FRAME_COUNT);
 
     while(true)
     {
-        cout << "Processing frame " << ++currentFrameNumber << " of " << totalFrames << endl;
-        cap >> frame;
+        {
+            lock_guard<mutex> lock(outputMutex);
+            cout << videoFile << ": processing frame " << ++currentFrameNumber << " of " << totalFrames << endl;
+        }
+        {
+            ScopedTimer timer("decode frame");
+            cap >> frame;
+        }
 
         if(frame.empty())
             break;
 
-        frame.copyTo(image);
-        classifier.Classify(image);
+        //The tracker does not keep the frame, so the rectangles are drawn on it directly
+        tracker.Track(frame);
+        if(tracker.getUnscoredFraction() > 0)
+            lateFrames++;
 
-        //Add rectangles to the image
-        int i = 0;
-        for(vector<Nest>::iterator it = classifier.nests.begin(); it != classifier.nests.end(); ++it)
+        //Add rectangles to the image, confirmed nests are counted once by their track id
+        for(vector<Nest>::iterator it = tracker.nests.begin(); it != tracker.nests.end(); ++it)
         {
+            if(it->probability >= parameters.threshold && it->state != Nest::BORN)
+                countedNests.insert(it->id);
+
+            if(detections.is_open())
+            {
+                detections << currentFrameNumber << "," << it->id << "," << it->state << "," << it->rect.x << ","
+                           << it->rect.y << "," << it->rect.width << "," << it->rect.height << ","
+                           << it->probability << "\n";
+            }
+
+            if(!outputVideo.isOpened() && !display)
+                continue;
             Scalar colour;
-            if(it->probability >= 0.5)
+            if(it->probability >= parameters.threshold)
                 colour = Scalar(0, 255, 0);
             else
                 colour = Scalar(255, 0, 0);
-            rectangle(image, it->rect, colour, 2, LINE_AA, 0);
-            putText(image, to_string(it->probability), it->rect.br(), FONT_HERSHEY_COMPLEX, 1, colour, 2, LINE_AA, 0);
+            int thickness = it->state == Nest::COASTING ? 1 : 2;
+            rectangle(frame, it->rect, colour, thickness, LINE_AA, 0);
+            putText(frame, "#" + to_string(it->id) + " " + to_string(it->probability), it->rect.br(),
+                    FONT_HERSHEY_COMPLEX, 1, colour, thickness, LINE_AA, 0);
         }
 
-        outputVideo << image;
-        imshow("Main", image);
-        waitKey(30);
+        if(outputVideo.isOpened())
+        {
+            ScopedTimer timer("write frame");
+            outputVideo << frame;
+        }
+#ifdef WITH_GUI
+        if(display)
+        {
+            imshow("Main", frame);
+            waitKey(30);
+        }
+#endif
     };
 
+    lock_guard<mutex> lock(outputMutex);
+    cout << videoFile << ": nests counted: " << countedNests.size() << endl;
+    if(parameters.frameBudget > 0)
+        cout << videoFile << ": frames finished in the next frame: " << lateFrames << endl;
     return 0;
-}
\ No newline at end of file
+}
+
+/*
+ * Writes the statistics of the stages and the trace of the run when they were requested
+ */
+static void writeProfile(const Parameters &parameters)
+{
+    if(parameters.profile.empty())
+        return;
+    Profiler::writeSummary(cout);
+    if(!Profiler::writeTrace(parameters.profile))
+        cerr << "Could not write the trace " << parameters.profile << endl;
+}
+
+int main(int argc, char** argv)
+{
+    help();
+    //Verify parameters
+    Parameters parameters;
+    vector<string> arguments;
+    //The tuned workers are images in flight of NestRecognition, here they are videos processed at the same time
+    if(!parameters.parseArguments(argc, argv, arguments, false) || arguments.size() < 3)
+    {
+        cerr << "Error in parameters" << endl;
+        return 1;
+    }
+    if(parameters.backend == "int8" && parameters.calibrationDir.empty())
+    {
+        cerr << "The int8 backend requires a folder of calibration crops, --calibrationDir=folder" << endl;
+        return 1;
+    }
+#ifndef WITH_OPENCV_DNN
+    if(parameters.backend == "opencv")
+    {
+        cerr << "The opencv backend requires building with WITH_OPENCV_DNN" << endl;
+        return 1;
+    }
+#endif
+    parameters.print(cout);
+    Profiler::enable(!parameters.profile.empty());
+    TaskPool::configure(parameters.poolThreads);
+
+    //Load parameters
+    string model = arguments[0];
+    string weights = arguments[1];
+    vector<string> videoFiles(arguments.begin() + 2, arguments.end());
+    unsigned long workers = parameters.workers > 0 ? (unsigned long) parameters.workers : videoFiles.size();
+    if(workers > videoFiles.size())
+        workers = videoFiles.size();
+
+    //The window can only be used by a single worker and requires HighGUI
+    bool display = false;
+#ifdef WITH_GUI
+    display = parameters.display && workers == 1;
+    if(display)
+        namedWindow("Main", WINDOW_NORMAL);
+#endif
+
+    //Create tracker, the ones of the other workers share its weights
+    chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+    Tracker tracker(model, weights, parameters);
+    cout << "Model loaded in " << chrono::duration_cast<chrono::milliseconds>(
+            chrono::high_resolution_clock::now() - start).count() << " ms" << endl;
+    if(workers == 1)
+    {
+        int result = 0;
+        for(vector<string>::iterator it = videoFiles.begin(); it != videoFiles.end(); ++it)
+        {
+            if(processVideo(tracker, *it, parameters, display) != 0)
+                result = -1;
+        }
+        writeProfile(parameters);
+        return result;
+    }
+
+    //Each worker takes the next video not processed yet
+    atomic<unsigned long> nextVideo(0);
+    atomic<int> result(0);
+    vector<thread> threads;
+    for(unsigned long r = 0; r < workers; ++r)
+    {
+        threads.push_back(thread([&]()
+        {
+            chrono::high_resolution_clock::time_point workerStart = chrono::high_resolution_clock::now();
+            Tracker workerTracker(tracker, parameters);
+            {
+                lock_guard<mutex> lock(outputMutex);
+                cout << "Worker tracker created in " << chrono::duration_cast<chrono::milliseconds>(
+                        chrono::high_resolution_clock::now() - workerStart).count() << " ms" << endl;
+            }
+            for(unsigned long video = nextVideo++; video < videoFiles.size(); video = nextVideo++)
+            {
+                if(processVideo(workerTracker, videoFiles[video], parameters, false) != 0)
+                    result = -1;
+            }
+        }));
+    }
+    for(vector<thread>::iterator it = threads.begin(); it != threads.end(); ++it)
+        it->join();
+
+    writeProfile(parameters);
+    return result;
+}